@@ -0,0 +1,1509 @@
+/********************************************************
+ *  NAME: Alan Guilfoyle
+ *  CLASS: CSCI 4730 - Operating Systems
+ *  PROJECT: 03 - File System Simulator
+ *
+ *  PURPOSE: To implement a simple UNIX-like file system
+ *      simulator in order to understand the hierarchical
+ *      directory and inode structures.
+ *********************************************************/
+
+//---IMPORT(S)---
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "fs.h"
+#include "fs_util.h"
+#include "cache.h"
+#include "bmap.h"
+
+/**
+ * Method: Number of block pointers that fit in one indirect block
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Return: int
+ */
+int bmap_per_block( fs_t * fs )
+{
+    return fs->superBlock.blockSize / sizeof( int );
+}
+
+
+
+/**
+ * Method: Largest number of data blocks a file can map. A pointer map
+ *  is bounded by the direct, single indirect and double indirect
+ *  pointers; an extent map by the int file size, as long as it stays
+ *  within extent_max_records. Inline files become extent mapped
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int flags - the inode's flags
+ *
+ * Return: long long
+ */
+long long bmap_max_blocks( fs_t * fs, int flags )
+{
+    long long perBlock = bmap_per_block( fs );
+    
+    if( flags & ( INODE_EXTENTS | INODE_INLINE ))
+    {
+        return 0x7FFFFFFF / fs->superBlock.blockSize;
+    }
+    
+    return DIRECT_BLOCK + perBlock + perBlock * perBlock;
+}
+
+
+
+/**
+ * Method: Number of indirect blocks a file of numBlock data blocks
+ *  needs, so callers can check for space before allocating
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int numBlock - the number of data blocks
+ *
+ * Return: int
+ */
+int bmap_meta_blocks( fs_t * fs, int numBlock )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int perBlock = bmap_per_block( fs );
+    int meta = 0;
+    
+    numBlock -= DIRECT_BLOCK;
+    
+    if( numBlock > 0 )
+    {
+        meta++;
+    }
+    
+    numBlock -= perBlock;
+    
+    if( numBlock > 0 )
+    {
+        meta += 1 + ( numBlock + perBlock - 1 ) / perBlock;
+    }
+    
+    return meta;
+}
+
+
+
+/**
+ * Method: Number of map blocks growing a file from blockNum to
+ *  newBlockNum data blocks may allocate, so callers can reserve them.
+ *  An extent map is charged as if every new block started a record
+ *  of its own; an inline file grows into an empty extent map
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int blockNum - the data blocks it has now
+ * @param: int newBlockNum - the data blocks it will have
+ *
+ * Return: int
+ */
+int bmap_grow_meta( fs_t * fs, int inodeNum, int blockNum, int newBlockNum )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int records;
+    //  Inode *(s)
+    Inode * node = &fs->inode[inodeNum];
+    
+    if( node->flags & ( INODE_EXTENTS | INODE_INLINE ))
+    {
+        records = ( node->flags & INODE_INLINE ) ? 0 : node->extentCount;
+        
+        return extent_meta_blocks( fs, records + newBlockNum - blockNum ) - extent_meta_blocks( fs, records );
+    }
+    
+    return bmap_meta_blocks( fs, newBlockNum ) - bmap_meta_blocks( fs, blockNum );
+}
+
+
+
+/**
+ * Method: Reads one pointer out of an indirect block
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int block - the indirect block
+ * @param: int slot - the pointer to read
+ *
+ * Return: int - the block it points to, 0 for none
+ */
+int bmap_read_ptr( fs_t * fs, int block, int slot )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int value;
+    //  char *(s)
+    char * data = cache_get( &fs->cache, block );
+    
+    if( data == NULL )
+    {
+        return 0;
+    }
+    
+    memcpy( &value, data + slot * sizeof( int ), sizeof( int ));
+    cache_release( &fs->cache, block, 0 );
+    
+    return value;
+}
+
+
+
+/**
+ * Method: Stores one pointer into an indirect block
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int block - the indirect block
+ * @param: int slot - the pointer to set
+ * @param: int value - the block it points to
+ *
+ * Return: int
+ */
+int bmap_write_ptr( fs_t * fs, int block, int slot, int value )
+{
+    char * data = cache_get( &fs->cache, block );
+    
+    if( data == NULL )
+    {
+        return -1;
+    }
+    
+    memcpy( data + slot * sizeof( int ), &value, sizeof( int ));
+    cache_release( &fs->cache, block, 1 );
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Allocates a zeroed indirect block
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Return: int - the block or -1 if the disk is full
+ */
+int bmap_new_block( fs_t * fs )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int got;
+    int block = alloc_extent( fs, -1, 1, &got );
+    //  char *(s)
+    char * zero;
+    
+    if( block < 0 )
+    {
+        return -1;
+    }
+    
+    zero = calloc( fs->superBlock.blockSize, 1 );
+    
+    if( zero == NULL || cache_write( &fs->cache, block, zero ) < 0 )
+    {
+        free( zero );
+        put_free_block( fs, block );
+        
+        return -1;
+    }
+    
+    free( zero );
+    
+    return block;
+}
+
+
+
+/**
+ * Method: Walks the inode's pointers to find one logical block
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int index - the logical block
+ *
+ * Return: int - the physical block, 0 if it is not mapped
+ */
+int bmap_walk( fs_t * fs, int inodeNum, int index )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int perBlock = bmap_per_block( fs );
+    int child;
+    //  Inode *(s)
+    Inode * node = &fs->inode[inodeNum];
+    
+    if( index < DIRECT_BLOCK )
+    {
+        return node->directBlock[index];
+    }
+    
+    index -= DIRECT_BLOCK;
+    
+    if( index < perBlock )
+    {
+        return node->indirectBlock ? bmap_read_ptr( fs, node->indirectBlock, index ) : 0;
+    }
+    
+    index -= perBlock;
+    
+    if( node->doubleIndirectBlock == 0 )
+    {
+        return 0;
+    }
+    
+    child = bmap_read_ptr( fs, node->doubleIndirectBlock, index / perBlock );
+    
+    return child ? bmap_read_ptr( fs, child, index % perBlock ) : 0;
+}
+
+
+
+/**
+ * Method: Copies up to count pointers out of an indirect block
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int block - the indirect block, 0 for none
+ * @param: int * out - where the pointers go
+ * @param: int count - how many to copy
+ *
+ * Return: None
+ */
+void bmap_copy_ptrs( fs_t * fs, int block, int * out, int count )
+{
+    char * data = block ? cache_get( &fs->cache, block ) : NULL;
+    
+    if( data == NULL )
+    {
+        memset( out, 0, count * sizeof( int ));
+        
+        return;
+    }
+    
+    memcpy( out, data, count * sizeof( int ));
+    cache_release( &fs->cache, block, 0 );
+}
+
+
+
+/**
+ * Method: Finds the cached translation of a file and marks it used.
+ *  The caller holds xlatLock
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ *
+ * Return: Xlat * - the translation or NULL if it is not cached
+ */
+Xlat * xlat_find( fs_t * fs, int inodeNum )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    
+    for( i = 0; i < XLAT_ENTRY; i++ )
+    {
+        if( fs->xlat[i].blocks != NULL && fs->xlat[i].inode == inodeNum )
+        {
+            fs->xlat[i].lastUse = ++fs->xlatClock;
+            
+            return &fs->xlat[i];
+        }
+    }
+    
+    return NULL;
+}
+
+
+
+/**
+ * Method: Builds the block list of a file by reading each of its
+ *  indirect blocks once; it runs without xlatLock, the caller holds
+ *  the inode's lock so the map can not change
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int * count - set to the number of entries, the file's
+ *      blockCount
+ * @param: int * cap - set to the length of the list's array
+ *
+ * Return: int * - the list or NULL if out of memory
+ */
+int * xlat_build( fs_t * fs, int inodeNum, int * count, int * cap )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int done;
+    int perBlock = bmap_per_block( fs );
+    int n = fs->inode[inodeNum].blockCount;
+    //  int *(s)
+    int * blocks;
+    //  Inode *(s)
+    Inode * node = &fs->inode[inodeNum];
+    
+    *count = n;
+    *cap = ( n > 16 ) ? n : 16;
+    
+    if(( blocks = malloc( *cap * sizeof( int ))) == NULL )
+    {
+        return NULL;
+    }
+    
+    done = ( n < DIRECT_BLOCK ) ? n : DIRECT_BLOCK;
+    memcpy( blocks, node->directBlock, done * sizeof( int ));
+    
+    if( done < n )
+    {
+        int count = ( n - done < perBlock ) ? n - done : perBlock;
+        
+        bmap_copy_ptrs( fs, node->indirectBlock, blocks + done, count );
+        done += count;
+    }
+    
+    if( done < n )
+    {
+        int numChild = ( n - done + perBlock - 1 ) / perBlock;
+        int * children = malloc( numChild * sizeof( int ));
+        
+        if( children == NULL )
+        {
+            free( blocks );
+            
+            return NULL;
+        }
+        
+        bmap_copy_ptrs( fs, node->doubleIndirectBlock, children, numChild );
+        
+        for( i = 0; i < numChild; i++ )
+        {
+            int count = ( n - done < perBlock ) ? n - done : perBlock;
+            
+            bmap_copy_ptrs( fs, children[i], blocks + done, count );
+            done += count;
+        }
+        
+        free( children );
+    }
+    
+    return blocks;
+}
+
+
+
+/**
+ * Method: Picks the entry a new translation goes in: the file's own
+ *  pinned entry, else an empty or the least recently used unpinned
+ *  one. There are more entries than descriptors, so one is always
+ *  free to take. The caller holds xlatLock
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ *
+ * Return: Xlat * - the entry
+ */
+Xlat * xlat_slot( fs_t * fs, int inodeNum )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int victim = -1;
+    
+    for( i = 0; i < XLAT_ENTRY; i++ )
+    {
+        Xlat * x = &fs->xlat[i];
+        
+        if( x->pin > 0 && x->inode == inodeNum )
+        {
+            return x;
+        }
+        
+        if( x->pin == 0 && ( victim < 0 || x->blocks == NULL || ( fs->xlat[victim].blocks != NULL && x->lastUse < fs->xlat[victim].lastUse )))
+        {
+            victim = i;
+        }
+    }
+    
+    return &fs->xlat[victim];
+}
+
+
+
+/**
+ * Method: Publishes a translation built by xlat_build in the entry
+ *  xlat_slot picks. A translation another thread put there first is
+ *  kept and this one freed. The caller holds xlatLock
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int * blocks - the list from xlat_build
+ * @param: int count - its number of entries
+ * @param: int cap - the length of its array
+ *
+ * Return: Xlat * - the translation
+ */
+Xlat * xlat_install( fs_t * fs, int inodeNum, int * blocks, int count, int cap )
+{
+    //---VARIABLE(S)---
+    //  Xlat *(s)
+    Xlat * x;
+    
+    if(( x = xlat_find( fs, inodeNum )) != NULL )
+    {
+        free( blocks );
+        
+        return x;
+    }
+    
+    x = xlat_slot( fs, inodeNum );
+    free( x->blocks );
+    x->blocks = blocks;
+    x->inode = inodeNum;
+    x->count = count;
+    x->cap = cap;
+    x->lastUse = ++fs->xlatClock;
+    
+    return x;
+}
+
+
+
+/**
+ * Method: Number of extent records that fit in an extent tree block
+ *  after its record count
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Return: int
+ */
+int extent_per_block( fs_t * fs )
+{
+    return ( fs->superBlock.blockSize - sizeof( int )) / sizeof( Extent );
+}
+
+
+
+/**
+ * Method: Largest number of extent records a file can hold: one index
+ *  block of leaves, each leaf full of records
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Return: int
+ */
+int extent_max_records( fs_t * fs )
+{
+    return extent_per_block( fs ) * extent_per_block( fs );
+}
+
+
+
+/**
+ * Method: Number of extent tree blocks a file of numRecord records
+ *  needs: none while they fit in the inode, then the index block and
+ *  one leaf per leaf full of records. Leaves fill in order, so growing
+ *  from a to b records costs the difference
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int numRecord - the number of extent records
+ *
+ * Return: int
+ */
+int extent_meta_blocks( fs_t * fs, int numRecord )
+{
+    int perBlock = extent_per_block( fs );
+    
+    if( numRecord > extent_max_records( fs ))
+    {
+        numRecord = extent_max_records( fs );
+    }
+    
+    if( numRecord <= INODE_EXTENT )
+    {
+        return 0;
+    }
+    
+    return 1 + ( numRecord + perBlock - 1 ) / perBlock;
+}
+
+
+
+/**
+ * Method: Binary search of a sorted run of extent records
+ *
+ * @param: Extent * records - the records, sorted by logical block
+ * @param: int count - the number of records
+ * @param: int logical - the logical block to look for
+ *
+ * Return: int - the last record starting at or before logical, or -1
+ */
+int extent_find( Extent * records, int count, int logical )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int low = 0;
+    int high = count - 1;
+    int found = -1;
+    
+    while( low <= high )
+    {
+        int mid = ( low + high ) / 2;
+        
+        if( records[mid].logical <= logical )
+        {
+            found = mid;
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+    
+    return found;
+}
+
+
+
+/**
+ * Method: Translates a logical block through a run of extent records
+ *
+ * @param: Extent * records - the records, sorted by logical block
+ * @param: int count - the number of records
+ * @param: int logical - the logical block
+ *
+ * Return: int - the physical block, 0 if it is not mapped
+ */
+int extent_map( Extent * records, int count, int logical )
+{
+    int i = extent_find( records, count, logical );
+    
+    if( i < 0 || logical >= records[i].logical + records[i].length )
+    {
+        return 0;
+    }
+    
+    return records[i].physical + ( logical - records[i].logical );
+}
+
+
+
+/**
+ * Method: Translates a logical block of an extent mapped file. The
+ *  records live in the inode until there are more than INODE_EXTENT
+ *  of them; then extentTree is an index block of (first logical
+ *  block, leaf block) records and each leaf holds the extents
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int index - the logical block
+ *
+ * Return: int - the physical block, 0 if it is not mapped
+ */
+int extent_get( fs_t * fs, int inodeNum, int index )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int leaf;
+    int block = 0;
+    //  char *(s)
+    char * data;
+    //  Inode *(s)
+    Inode * node = &fs->inode[inodeNum];
+    
+    if( node->extentTree == 0 )
+    {
+        return extent_map( node->extent, node->extentCount, index );
+    }
+    
+    if(( data = cache_get( &fs->cache, node->extentTree )) == NULL )
+    {
+        return 0;
+    }
+    
+    i = extent_find(( Extent * )( data + sizeof( int )), *( int * ) data, index );
+    leaf = ( i >= 0 ) ? (( Extent * )( data + sizeof( int )))[i].physical : 0;
+    cache_release( &fs->cache, node->extentTree, 0 );
+    
+    if( leaf != 0 && ( data = cache_get( &fs->cache, leaf )) != NULL )
+    {
+        block = extent_map(( Extent * )( data + sizeof( int )), *( int * ) data, index );
+        cache_release( &fs->cache, leaf, 0 );
+    }
+    
+    return block;
+}
+
+
+
+/**
+ * Method: Adds a record to an extent tree block
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int block - the index or leaf block
+ * @param: Extent * record - the record to append
+ *
+ * Return: int - 0, or -1 if the block is full
+ */
+int extent_push( fs_t * fs, int block, Extent * record )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int count;
+    //  char *(s)
+    char * data = cache_get( &fs->cache, block );
+    
+    if( data == NULL )
+    {
+        return -1;
+    }
+    
+    count = *( int * ) data;
+    
+    if( count >= extent_per_block( fs ))
+    {
+        cache_release( &fs->cache, block, 0 );
+        
+        return -1;
+    }
+    
+    (( Extent * )( data + sizeof( int )))[count] = *record;
+    *( int * ) data = count + 1;
+    cache_release( &fs->cache, block, 1 );
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Moves the records out of the inode into a new leaf under a
+ *  new index block once they no longer fit
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ *
+ * Return: int - the leaf block or -1 if the disk is full
+ */
+int extent_spill( fs_t * fs, int inodeNum )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int leaf;
+    int index;
+    //  Inode *(s)
+    Inode * node = &fs->inode[inodeNum];
+    //  Extent(s)
+    Extent entry;
+    
+    if(( leaf = bmap_new_block( fs )) < 0 )
+    {
+        return -1;
+    }
+    
+    if(( index = bmap_new_block( fs )) < 0 )
+    {
+        put_free_block( fs, leaf );
+        
+        return -1;
+    }
+    
+    for( i = 0; i < node->extentCount; i++ )
+    {
+        extent_push( fs, leaf, &node->extent[i] );
+    }
+    
+    entry.logical = node->extent[0].logical;
+    entry.physical = leaf;
+    entry.length = 0;
+    extent_push( fs, index, &entry );
+    
+    memset( node->extent, 0, sizeof( node->extent ));
+    node->extentTree = index;
+    
+    return leaf;
+}
+
+
+
+/**
+ * Method: Maps the next logical block of an extent mapped file. The
+ *  last extent grows when the block follows it on the disk, so a
+ *  contiguous file needs a single record; otherwise a new record is
+ *  appended, spilling to the extent tree when the inode is full.
+ *  Blocks are only ever added past the end of the file
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int index - the logical block
+ * @param: int block - the physical block
+ *
+ * Return: int
+ */
+int extent_set( fs_t * fs, int inodeNum, int index, int block )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int count;
+    int leaf = 0;
+    //  char *(s)
+    char * data = NULL;
+    //  Inode *(s)
+    Inode * node = &fs->inode[inodeNum];
+    //  Extent(s)
+    Extent * last = NULL;
+    Extent record;
+    
+    if( node->extentTree == 0 )
+    {
+        last = node->extentCount ? &node->extent[node->extentCount - 1] : NULL;
+    }
+    else
+    {
+        //  The last extent is at the end of the last leaf
+        if(( data = cache_get( &fs->cache, node->extentTree )) == NULL )
+        {
+            return -1;
+        }
+        
+        count = *( int * ) data;
+        leaf = (( Extent * )( data + sizeof( int )))[count - 1].physical;
+        cache_release( &fs->cache, node->extentTree, 0 );
+        
+        if(( data = cache_get( &fs->cache, leaf )) == NULL )
+        {
+            return -1;
+        }
+        
+        count = *( int * ) data;
+        last = count ? &(( Extent * )( data + sizeof( int )))[count - 1] : NULL;
+    }
+    
+    if( last != NULL && index < last->logical + last->length )
+    {
+        fprintf( stderr, "extent map: block %d of inode %d is already mapped\n", index, inodeNum );
+        
+        if( data != NULL )
+        {
+            cache_release( &fs->cache, leaf, 0 );
+        }
+        
+        return -1;
+    }
+    
+    if( last != NULL && last->logical + last->length == index && last->physical + last->length == block )
+    {
+        last->length++;
+        
+        if( data != NULL )
+        {
+            cache_release( &fs->cache, leaf, 1 );
+        }
+        
+        return 0;
+    }
+    
+    if( data != NULL )
+    {
+        cache_release( &fs->cache, leaf, 0 );
+    }
+    
+    record.logical = index;
+    record.physical = block;
+    record.length = 1;
+    
+    if( node->extentTree == 0 && node->extentCount < INODE_EXTENT )
+    {
+        node->extent[node->extentCount++] = record;
+        
+        return 0;
+    }
+    
+    if( node->extentTree == 0 && ( leaf = extent_spill( fs, inodeNum )) < 0 )
+    {
+        return -1;
+    }
+    
+    if( leaf == 0 || extent_push( fs, leaf, &record ) < 0 )
+    {
+        //  The last leaf is full: start a new one
+        Extent entry;
+        
+        if(( leaf = bmap_new_block( fs )) < 0 )
+        {
+            return -1;
+        }
+        
+        entry.logical = index;
+        entry.physical = leaf;
+        entry.length = 0;
+        
+        if( extent_push( fs, node->extentTree, &entry ) < 0 )
+        {
+            fprintf( stderr, "extent map: inode %d has too many extents\n", inodeNum );
+            put_free_block( fs, leaf );
+            
+            return -1;
+        }
+        
+        extent_push( fs, leaf, &record );
+    }
+    
+    node->extentCount++;
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Frees the data blocks in a run of extent records
+ *
+ * @param: fs_t * fs - the volume
+ * @param: Extent * records - the records
+ * @param: int count - the number of records
+ *
+ * Return: None
+ */
+void extent_free_records( fs_t * fs, Extent * records, int count )
+{
+    int i;
+    int k;
+    
+    for( i = 0; i < count; i++ )
+    {
+        for( k = 0; k < records[i].length; k++ )
+        {
+            put_free_block( fs, records[i].physical + k );
+        }
+    }
+}
+
+
+
+/**
+ * Method: Frees every data block and extent tree block of an extent
+ *  mapped file
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ *
+ * Return: None
+ */
+void extent_free( fs_t * fs, int inodeNum )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int numLeaf;
+    int * leaves;
+    //  char *(s)
+    char * data;
+    //  Inode *(s)
+    Inode * node = &fs->inode[inodeNum];
+    
+    if( node->extentTree == 0 )
+    {
+        extent_free_records( fs, node->extent, node->extentCount );
+        
+        return;
+    }
+    
+    if(( data = cache_get( &fs->cache, node->extentTree )) == NULL )
+    {
+        return;
+    }
+    
+    numLeaf = *( int * ) data;
+    leaves = malloc( numLeaf * sizeof( int ));
+    
+    for( i = 0; leaves != NULL && i < numLeaf; i++ )
+    {
+        leaves[i] = (( Extent * )( data + sizeof( int )))[i].physical;
+    }
+    
+    cache_release( &fs->cache, node->extentTree, 0 );
+    
+    for( i = 0; leaves != NULL && i < numLeaf; i++ )
+    {
+        if(( data = cache_get( &fs->cache, leaves[i] )) != NULL )
+        {
+            extent_free_records( fs, ( Extent * )( data + sizeof( int )), *( int * ) data );
+            cache_release( &fs->cache, leaves[i], 0 );
+        }
+        
+        put_free_block( fs, leaves[i] );
+    }
+    
+    free( leaves );
+    put_free_block( fs, node->extentTree );
+}
+
+
+
+/**
+ * Method: Frees the blocks of a run of extent records from logical
+ *  block first on, shortening or dropping the records that hold them
+ *
+ * @param: fs_t * fs - the volume
+ * @param: Extent * records - the records, sorted by logical block
+ * @param: int count - the number of records
+ * @param: int first - the first logical block to free
+ *
+ * Return: int - the number of records left
+ */
+int extent_trim_records( fs_t * fs, Extent * records, int count, int first )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int k;
+    int keep;
+    //  Extent(s)
+    Extent * last;
+    
+    while( count > 0 && records[count - 1].logical + records[count - 1].length > first )
+    {
+        last = &records[count - 1];
+        keep = ( first > last->logical ) ? first - last->logical : 0;
+        
+        for( k = keep; k < last->length; k++ )
+        {
+            put_free_block( fs, last->physical + k );
+        }
+        
+        if( keep > 0 )
+        {
+            last->length = keep;
+            
+            break;
+        }
+        
+        memset( last, 0, sizeof( Extent ));
+        count--;
+    }
+    
+    return count;
+}
+
+
+
+/**
+ * Method: Frees the blocks of an extent mapped file from logical block
+ *  first on. Leaves emptied from the end of the tree are freed too,
+ *  except the first one
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int first - the first logical block to free
+ *
+ * Return: None
+ */
+void extent_trim( fs_t * fs, int inodeNum, int first )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int numLeaf;
+    int leaf;
+    int before;
+    int after;
+    //  char *(s)
+    char * data;
+    //  Inode *(s)
+    Inode * node = &fs->inode[inodeNum];
+    
+    if( node->extentTree == 0 )
+    {
+        node->extentCount = extent_trim_records( fs, node->extent, node->extentCount, first );
+        
+        return;
+    }
+    
+    while(( data = cache_get( &fs->cache, node->extentTree )) != NULL )
+    {
+        numLeaf = *( int * ) data;
+        leaf = (( Extent * )( data + sizeof( int )))[numLeaf - 1].physical;
+        cache_release( &fs->cache, node->extentTree, 0 );
+        
+        if(( data = cache_get( &fs->cache, leaf )) == NULL )
+        {
+            return;
+        }
+        
+        before = *( int * ) data;
+        after = extent_trim_records( fs, ( Extent * )( data + sizeof( int )), before, first );
+        *( int * ) data = after;
+        cache_release( &fs->cache, leaf, after != before );
+        node->extentCount -= before - after;
+        
+        //  Stop at the first leaf that keeps a record
+        if( after > 0 || numLeaf == 1 )
+        {
+            return;
+        }
+        
+        if(( data = cache_get( &fs->cache, node->extentTree )) == NULL )
+        {
+            return;
+        }
+        
+        *( int * ) data = numLeaf - 1;
+        cache_release( &fs->cache, node->extentTree, 1 );
+        put_free_block( fs, leaf );
+    }
+}
+
+
+
+/**
+ * Method: Translates a logical block of a file to its physical block
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int index - the logical block
+ *
+ * Return: int - the physical block, 0 if it is not mapped
+ */
+int bmap_get( fs_t * fs, int inodeNum, int index )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int block = -1;
+    int gen;
+    int count;
+    int cap;
+    //  int *(s)
+    int * blocks;
+    //  Xlat *(s)
+    Xlat * x;
+    
+    if( index < 0 || index >= bmap_max_blocks( fs, fs->inode[inodeNum].flags ) || ( fs->inode[inodeNum].flags & INODE_INLINE ))
+    {
+        return 0;
+    }
+    
+    if( fs->inode[inodeNum].flags & INODE_EXTENTS )
+    {
+        return extent_get( fs, inodeNum, index );
+    }
+    
+    //  Readers of different files share the translations
+    pthread_mutex_lock( &fs->xlatLock );
+    
+    if(( x = xlat_find( fs, inodeNum )) == NULL )
+    {
+        //  A miss reads indirect blocks, so it is built without the
+        //  lock and only published if no map changed meanwhile
+        gen = fs->xlatGen;
+        pthread_mutex_unlock( &fs->xlatLock );
+        blocks = xlat_build( fs, inodeNum, &count, &cap );
+        pthread_mutex_lock( &fs->xlatLock );
+        
+        if( blocks != NULL && gen != fs->xlatGen )
+        {
+            free( blocks );
+        }
+        else if( blocks != NULL )
+        {
+            x = xlat_install( fs, inodeNum, blocks, count, cap );
+        }
+    }
+    
+    if( x != NULL && index < x->count )
+    {
+        block = x->blocks[index];
+    }
+    
+    pthread_mutex_unlock( &fs->xlatLock );
+    
+    return ( block >= 0 ) ? block : bmap_walk( fs, inodeNum, index );
+}
+
+
+
+/**
+ * Method: Maps a logical block of a file to a physical block,
+ *  allocating the indirect blocks on the way when needed
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int index - the logical block
+ * @param: int block - the physical block
+ *
+ * Return: int
+ */
+int bmap_set( fs_t * fs, int inodeNum, int index, int block )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int slot = index;
+    int perBlock = bmap_per_block( fs );
+    int child;
+    //  Inode *(s)
+    Inode * node = &fs->inode[inodeNum];
+    
+    if( index < 0 || index >= bmap_max_blocks( fs, node->flags ) || ( node->flags & INODE_INLINE ))
+    {
+        return -1;
+    }
+    
+    if( node->flags & INODE_EXTENTS )
+    {
+        if( extent_set( fs, inodeNum, index, block ) < 0 )
+        {
+            return -1;
+        }
+        
+        dirty_inode( fs, inodeNum );
+        
+        return 0;
+    }
+    
+    if( slot < DIRECT_BLOCK )
+    {
+        node->directBlock[slot] = block;
+    }
+    else if(( slot -= DIRECT_BLOCK ) < perBlock )
+    {
+        if( node->indirectBlock == 0 && ( node->indirectBlock = bmap_new_block( fs )) < 0 )
+        {
+            node->indirectBlock = 0;
+            
+            return -1;
+        }
+        
+        bmap_write_ptr( fs, node->indirectBlock, slot, block );
+    }
+    else
+    {
+        slot -= perBlock;
+        
+        if( node->doubleIndirectBlock == 0 && ( node->doubleIndirectBlock = bmap_new_block( fs )) < 0 )
+        {
+            node->doubleIndirectBlock = 0;
+            
+            return -1;
+        }
+        
+        child = bmap_read_ptr( fs, node->doubleIndirectBlock, slot / perBlock );
+        
+        if( child == 0 )
+        {
+            if(( child = bmap_new_block( fs )) < 0 )
+            {
+                return -1;
+            }
+            
+            bmap_write_ptr( fs, node->doubleIndirectBlock, slot / perBlock, child );
+        }
+        
+        bmap_write_ptr( fs, child, slot % perBlock, block );
+    }
+    
+    dirty_inode( fs, inodeNum );
+    
+    //  Keep a cached translation in step
+    pthread_mutex_lock( &fs->xlatLock );
+    fs->xlatGen++;
+    
+    for( i = 0; i < XLAT_ENTRY; i++ )
+    {
+        Xlat * x = &fs->xlat[i];
+        
+        if( x->blocks == NULL || x->inode != inodeNum )
+        {
+            continue;
+        }
+        
+        if( index >= x->cap )
+        {
+            int newCap = ( index + 1 > x->cap * 2 ) ? index + 1 : x->cap * 2;
+            int * grown = realloc( x->blocks, newCap * sizeof( int ));
+            
+            if( grown == NULL )
+            {
+                free( x->blocks );
+                x->blocks = NULL;
+                
+                break;
+            }
+            
+            x->blocks = grown;
+            x->cap = newCap;
+        }
+        
+        while( x->count < index )
+        {
+            x->blocks[x->count++] = 0;
+        }
+        
+        x->blocks[index] = block;
+        
+        if( x->count == index )
+        {
+            x->count++;
+        }
+    }
+    
+    pthread_mutex_unlock( &fs->xlatLock );
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Frees every data and indirect block of a file and clears
+ *  its pointers
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ *
+ * Return: None
+ */
+void bmap_free( fs_t * fs, int inodeNum )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int block;
+    int perBlock = bmap_per_block( fs );
+    //  Inode *(s)
+    Inode * node = &fs->inode[inodeNum];
+    
+    if( node->flags & ( INODE_EXTENTS | INODE_INLINE ))
+    {
+        if( node->flags & INODE_EXTENTS )
+        {
+            extent_free( fs, inodeNum );
+        }
+        
+        bmap_init( fs, inodeNum, node->flags );
+        
+        return;
+    }
+    
+    for( i = 0; i < node->blockCount; i++ )
+    {
+        if(( block = bmap_get( fs, inodeNum, i )) != 0 )
+        {
+            put_free_block( fs, block );
+        }
+    }
+    
+    if( node->indirectBlock != 0 )
+    {
+        put_free_block( fs, node->indirectBlock );
+    }
+    
+    if( node->doubleIndirectBlock != 0 )
+    {
+        for( i = 0; i < perBlock; i++ )
+        {
+            if(( block = bmap_read_ptr( fs, node->doubleIndirectBlock, i )) != 0 )
+            {
+                put_free_block( fs, block );
+            }
+        }
+        
+        put_free_block( fs, node->doubleIndirectBlock );
+    }
+    
+    bmap_init( fs, inodeNum, node->flags );
+}
+
+
+
+/**
+ * Method: Frees the blocks mapped at logical blocks [first, last) of
+ *  a file and clears their pointers; used to give back the end of a
+ *  map when growing a file fails part way. Indirect blocks stay until
+ *  the file is freed
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int first - the first logical block to free
+ * @param: int last - one past the last logical block, the end of the
+ *      map
+ *
+ * Return: None
+ */
+void bmap_unmap( fs_t * fs, int inodeNum, int first, int last )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int block;
+    //  Inode *(s)
+    Inode * node = &fs->inode[inodeNum];
+    
+    if( node->flags & INODE_INLINE )
+    {
+        return;
+    }
+    
+    if( node->flags & INODE_EXTENTS )
+    {
+        extent_trim( fs, inodeNum, first );
+    }
+    else
+    {
+        for( i = first; i < last; i++ )
+        {
+            if(( block = bmap_get( fs, inodeNum, i )) != 0 )
+            {
+                put_free_block( fs, block );
+                bmap_set( fs, inodeNum, i, 0 );
+            }
+        }
+    }
+    
+    dirty_inode( fs, inodeNum );
+}
+
+
+
+/**
+ * Method: Empties the block map or inline data of an inode and picks
+ *  its format; called for a new inode, which may hold a removed
+ *  file's map
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the inode
+ * @param: int flags - INODE_EXTENTS for an extent map, INODE_INLINE
+ *      for inline data, 0 for pointers
+ *
+ * Return: None
+ */
+void bmap_init( fs_t * fs, int inodeNum, int flags )
+{
+    Inode * node = &fs->inode[inodeNum];
+    
+    memset( node->inlineData, 0, INLINE_DATA );
+    node->flags = flags;
+    node->blockCount = 0;
+    dirty_inode( fs, inodeNum );
+    
+    bmap_invalidate( fs, inodeNum );
+}
+
+
+
+/**
+ * Method: Drops the cached translation of a file
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ *
+ * Return: None
+ */
+void bmap_invalidate( fs_t * fs, int inodeNum )
+{
+    int i;
+    
+    pthread_mutex_lock( &fs->xlatLock );
+    fs->xlatGen++;
+    
+    for( i = 0; i < XLAT_ENTRY; i++ )
+    {
+        if( fs->xlat[i].blocks != NULL && fs->xlat[i].inode == inodeNum )
+        {
+            free( fs->xlat[i].blocks );
+            fs->xlat[i].blocks = NULL;
+        }
+    }
+    
+    pthread_mutex_unlock( &fs->xlatLock );
+}
+
+
+
+/**
+ * Method: Keeps the translation of a file cached while a descriptor
+ *  has it open, so reads and writes through descriptors do not evict
+ *  each other's; called by file_open
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ *
+ * Return: None
+ */
+void bmap_pin( fs_t * fs, int inodeNum )
+{
+    //---VARIABLE(S)---
+    //  Xlat *(s)
+    Xlat * x;
+    
+    pthread_mutex_lock( &fs->xlatLock );
+    
+    if(( x = xlat_find( fs, inodeNum )) == NULL && ( x = xlat_slot( fs, inodeNum ))->pin == 0 )
+    {
+        free( x->blocks );
+        x->blocks = NULL;
+        x->inode = inodeNum;
+        x->count = 0;
+    }
+    
+    x->pin++;
+    pthread_mutex_unlock( &fs->xlatLock );
+}
+
+
+
+/**
+ * Method: Lets go of a pin from bmap_pin; called by file_close. The
+ *  translation stays cached like any other
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ *
+ * Return: None
+ */
+void bmap_unpin( fs_t * fs, int inodeNum )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    
+    pthread_mutex_lock( &fs->xlatLock );
+    
+    for( i = 0; i < XLAT_ENTRY; i++ )
+    {
+        if( fs->xlat[i].pin > 0 && fs->xlat[i].inode == inodeNum )
+        {
+            fs->xlat[i].pin--;
+            
+            break;
+        }
+    }
+    
+    pthread_mutex_unlock( &fs->xlatLock );
+}
+
+
+
+/**
+ * Method: Drops every cached translation and pin at unmount
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Return: None
+ */
+void bmap_destroy( fs_t * fs )
+{
+    int i;
+    
+    for( i = 0; i < XLAT_ENTRY; i++ )
+    {
+        free( fs->xlat[i].blocks );
+        fs->xlat[i].blocks = NULL;
+        fs->xlat[i].pin = 0;
+    }
+}
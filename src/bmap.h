@@ -0,0 +1,47 @@
+/********************************************************
+ *  NAME: Alan Guilfoyle
+ *  CLASS: CSCI 4730 - Operating Systems
+ *  PROJECT: 03 - File System Simulator
+ *
+ *  PURPOSE: To implement a simple UNIX-like file system
+ *      simulator in order to understand the hierarchical
+ *      directory and inode structures.
+ *********************************************************/
+
+#ifndef BMAP_H
+#define BMAP_H
+
+//---DEFINITION(S)---
+#define XLAT_ENTRY ( OPEN_FILE + 8 )
+
+//The physical block of every logical block of one file, so lookups
+//  do not walk the indirect blocks again. pin counts the descriptors
+//  open on the file; a pinned entry keeps its file, blocks may be NULL
+//  until the first lookup
+typedef struct
+{
+        int inode;
+        int count;
+        int cap;
+        int lastUse;
+        int pin;
+        int * blocks;
+} Xlat;
+
+//---METHOD INSTANTIATION(S)---
+long long bmap_max_blocks( fs_t * fs, int flags );
+int bmap_meta_blocks( fs_t * fs, int numBlock );
+int extent_max_records( fs_t * fs );
+int extent_meta_blocks( fs_t * fs, int numRecord );
+int bmap_grow_meta( fs_t * fs, int inodeNum, int blockNum, int newBlockNum );
+int bmap_get( fs_t * fs, int inodeNum, int index );
+int bmap_set( fs_t * fs, int inodeNum, int index, int block );
+void bmap_free( fs_t * fs, int inodeNum );
+void bmap_unmap( fs_t * fs, int inodeNum, int first, int last );
+void bmap_init( fs_t * fs, int inodeNum, int flags );
+void bmap_invalidate( fs_t * fs, int inodeNum );
+void bmap_pin( fs_t * fs, int inodeNum );
+void bmap_unpin( fs_t * fs, int inodeNum );
+void bmap_destroy( fs_t * fs );
+
+#endif
@@ -0,0 +1,911 @@
+/********************************************************
+ *  NAME: Alan Guilfoyle
+ *  CLASS: CSCI 4730 - Operating Systems
+ *  PROJECT: 03 - File System Simulator
+ *
+ *  PURPOSE: To implement a simple UNIX-like file system
+ *      simulator in order to understand the hierarchical
+ *      directory and inode structures.
+ *********************************************************/
+
+//---IMPORT(S)---
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "cache.h"
+#include "disk.h"
+
+//---DEFINITION(S)---
+#define BUFFER_ALIGN 4096
+#define CACHE_RACED -2
+
+/**
+ * Method: Sets a cache handle up in front of a disk, with the default
+ *  size and no buffers
+ *
+ * @param: cache_t * cache - the cache
+ * @param: disk_t * disk - the disk the cache reads and writes
+ *
+ * Return: None
+ */
+void cache_setup( cache_t * cache, disk_t * disk )
+{
+    memset( cache, 0, sizeof( cache_t ));
+    pthread_mutex_init( &cache->lock, NULL );
+    pthread_cond_init( &cache->done, NULL );
+    cache->disk = disk;
+    cache->size = DEFAULT_CACHE_BLOCK;
+}
+
+
+
+/**
+ * Method: Sets how many blocks the cache holds; takes effect at
+ *  the next cache_init
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int numBuffer - number of block buffers
+ *
+ * Return: int
+ */
+int cache_set_size( cache_t * cache, int numBuffer )
+{
+    if( numBuffer < MIN_CACHE_BLOCK )
+    {
+        fprintf( stderr, "cache: need at least %d buffers\n", MIN_CACHE_BLOCK );
+
+        return -1;
+    }
+
+    cache->size = numBuffer;
+
+    return 0;
+}
+
+
+
+/**
+ * Method: Allocates the buffers once the block size is known; until
+ *  then cache_read / cache_write go straight to the disk
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int blockSize - bytes per block
+ *
+ * Return: int
+ */
+int cache_init( cache_t * cache, int blockSize )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int numBucket = 1;
+
+    while( numBucket < cache->size * 2 )
+    {
+        numBucket <<= 1;
+    }
+
+    cache->buffers = calloc( cache->size, sizeof( Buffer ));
+    cache->hashHead = malloc( numBucket * sizeof( int ));
+
+    if( cache->buffers == NULL || cache->hashHead == NULL )
+    {
+        fprintf( stderr, "cache: out of memory\n" );
+        free( cache->buffers );
+        free( cache->hashHead );
+        cache->buffers = NULL;
+        cache->hashHead = NULL;
+
+        return -1;
+    }
+
+    for( i = 0; i < cache->size; i++ )
+    {
+        cache->buffers[i].block = -1;
+        cache->buffers[i].next = -1;
+        //  Aligned so O_DIRECT can write buffers without a bounce copy
+        if( posix_memalign(( void ** ) &cache->buffers[i].data, BUFFER_ALIGN, blockSize ) != 0 )
+        {
+            fprintf( stderr, "cache: out of memory\n" );
+            cache->numBuffers = i;
+            cache_destroy( cache );
+
+            return -1;
+        }
+    }
+
+    for( i = 0; i < numBucket; i++ )
+    {
+        cache->hashHead[i] = -1;
+    }
+
+    cache->numBuffers = cache->size;
+    cache->blockSize = blockSize;
+    cache->hashMask = numBucket - 1;
+    cache->clockHand = 0;
+
+    return 0;
+}
+
+
+
+/**
+ * Method: Writes back every dirty buffer and frees the cache
+ *
+ * @param: cache_t * cache - the cache
+ *
+ * Return: int
+ */
+int cache_destroy( cache_t * cache )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int result = cache_flush( cache );
+
+    for( i = 0; i < cache->numBuffers; i++ )
+    {
+        free( cache->buffers[i].data );
+    }
+
+    free( cache->buffers );
+    free( cache->hashHead );
+    cache->buffers = NULL;
+    cache->hashHead = NULL;
+    cache->numBuffers = 0;
+
+    return result;
+}
+
+
+
+/**
+ * Method: Finds the buffer holding a block
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int block - the block number
+ *
+ * Return: int - the buffer index or -1 if the block is not cached
+ */
+int cache_lookup( cache_t * cache, int block )
+{
+    int i = cache->hashHead[block & cache->hashMask];
+
+    while( i >= 0 && cache->buffers[i].block != block )
+    {
+        i = cache->buffers[i].next;
+    }
+
+    return i;
+}
+
+
+
+/**
+ * Method: Removes a buffer from its hash chain
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int index - the buffer index
+ *
+ * Return: None
+ */
+void cache_unhash( cache_t * cache, int index )
+{
+    int * link = &cache->hashHead[cache->buffers[index].block & cache->hashMask];
+
+    while( *link != index )
+    {
+        link = &cache->buffers[*link].next;
+    }
+
+    *link = cache->buffers[index].next;
+    cache->buffers[index].next = -1;
+}
+
+
+
+/**
+ * Method: Marks a buffer busy and drops the lock for its disk I/O
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int index - the buffer index
+ *
+ * Return: None
+ */
+void cache_io_start( cache_t * cache, int index )
+{
+    cache->buffers[index].busy = 1;
+    pthread_mutex_unlock( &cache->lock );
+}
+
+
+
+/**
+ * Method: Takes the lock back after a buffer's disk I/O and wakes
+ *  whoever waits for it
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int index - the buffer index
+ *
+ * Return: None
+ */
+void cache_io_end( cache_t * cache, int index )
+{
+    pthread_mutex_lock( &cache->lock );
+    cache->buffers[index].busy = 0;
+    pthread_cond_broadcast( &cache->done );
+}
+
+
+
+/**
+ * Method: Finds the buffer holding a block, waiting while it is busy;
+ *  the block may be gone once the wait is over
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int block - the block number
+ *
+ * Return: int - the buffer index or -1 if the block is not cached
+ */
+int cache_lookup_idle( cache_t * cache, int block )
+{
+    int i;
+
+    while(( i = cache_lookup( cache, block )) >= 0 && cache->buffers[i].busy )
+    {
+        pthread_cond_wait( &cache->done, &cache->lock );
+    }
+
+    return i;
+}
+
+
+
+/**
+ * Method: Writes a dirty buffer back to the disk; the lock is dropped
+ *  for the write
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int index - the buffer index
+ *
+ * Return: int
+ */
+int cache_writeback( cache_t * cache, int index )
+{
+    int result;
+
+    if( !cache->buffers[index].dirty )
+    {
+        return 0;
+    }
+
+    cache_io_start( cache, index );
+    result = disk_write( cache->disk, cache->buffers[index].block, cache->buffers[index].data );
+    cache_io_end( cache, index );
+
+    if( result < 0 )
+    {
+        return -1;
+    }
+
+    cache->buffers[index].dirty = 0;
+    cache->writebacks++;
+
+    return 0;
+}
+
+
+
+/**
+ * Method: Picks a buffer for a new block with the CLOCK algorithm;
+ *  recently referenced buffers get a second chance and pinned or busy
+ *  buffers are skipped. The victim is written back if dirty, which
+ *  drops the lock, so the block may be cached by then
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int block - the block the buffer will hold
+ * @param: int wait - 1 to wait for busy buffers when nothing else
+ *      can go, 0 when the caller holds some of them busy itself
+ *
+ * Return: int - the buffer index, CACHE_RACED if another thread
+ *      cached the block meanwhile, or -1 if every buffer is pinned
+ */
+int cache_evict( cache_t * cache, int block, int wait )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int sweep;
+    int i;
+    int busy = 0;
+
+    //  Two full turns clear every reference bit
+    for( sweep = 0; sweep < cache->numBuffers * 2; sweep++ )
+    {
+        i = cache->clockHand;
+        cache->clockHand = ( cache->clockHand + 1 ) % cache->numBuffers;
+
+        if( cache->buffers[i].busy )
+        {
+            busy = 1;
+
+            continue;
+        }
+
+        if( cache->buffers[i].pinned > 0 )
+        {
+            continue;
+        }
+
+        if( cache->buffers[i].referenced )
+        {
+            cache->buffers[i].referenced = 0;
+
+            continue;
+        }
+
+        if( cache->buffers[i].block >= 0 )
+        {
+            if( cache_writeback( cache, i ) < 0 )
+            {
+                return -1;
+            }
+
+            if( cache_lookup( cache, block ) >= 0 )
+            {
+                return CACHE_RACED;
+            }
+
+            //  Someone took the victim back while it was written
+            if( cache->buffers[i].pinned > 0 || cache->buffers[i].referenced || cache->buffers[i].dirty )
+            {
+                continue;
+            }
+
+            cache_unhash( cache, i );
+        }
+
+        cache->buffers[i].block = block;
+        cache->buffers[i].next = cache->hashHead[block & cache->hashMask];
+        cache->hashHead[block & cache->hashMask] = i;
+
+        return i;
+    }
+
+    //  Buffers in flight free up once their I/O is done
+    if( busy && wait )
+    {
+        pthread_cond_wait( &cache->done, &cache->lock );
+
+        return ( cache_lookup( cache, block ) >= 0 ) ? CACHE_RACED : cache_evict( cache, block, wait );
+    }
+
+    if( busy )
+    {
+        return -1;
+    }
+
+    fprintf( stderr, "cache: every buffer is pinned\n" );
+
+    return -1;
+}
+
+
+
+/**
+ * Method: Finds or loads the buffer for a block
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int block - the block number
+ * @param: int load - 1 to read the block on a miss, 0 when the
+ *      caller is about to overwrite all of it
+ *
+ * Return: int - the buffer index or -1 on error
+ */
+int cache_fetch( cache_t * cache, int block, int load )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int result = 0;
+
+    //  Evicting drops the lock, so look again when it lost a race
+    for( ;; )
+    {
+        if(( i = cache_lookup_idle( cache, block )) >= 0 )
+        {
+            cache->hits++;
+            cache->buffers[i].referenced = 1;
+
+            return i;
+        }
+
+        if(( i = cache_evict( cache, block, 1 )) != CACHE_RACED )
+        {
+            break;
+        }
+    }
+
+    if( i < 0 )
+    {
+        return -1;
+    }
+
+    cache->misses++;
+    cache->buffers[i].referenced = 1;
+
+    if( load )
+    {
+        //  Readers of the block wait for the buffer, not for the lock
+        cache_io_start( cache, i );
+        result = disk_read( cache->disk, block, cache->buffers[i].data );
+        cache_io_end( cache, i );
+    }
+
+    if( result < 0 )
+    {
+        cache_unhash( cache, i );
+        cache->buffers[i].block = -1;
+        cache->buffers[i].referenced = 0;
+
+        return -1;
+    }
+
+    return i;
+}
+
+
+
+/**
+ * Method: Copies a block out of the cache
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int block - the block number
+ * @param: char * buf - where the block is copied to
+ *
+ * Return: int
+ */
+int cache_read( cache_t * cache, int block, char * buf )
+{
+    int i;
+
+    if( cache->numBuffers == 0 )
+    {
+        return disk_read( cache->disk, block, buf );
+    }
+
+    if( block < 0 || block >= cache->disk->blockCount )
+    {
+        printf( "disk_read error\n" );
+
+        return -1;
+    }
+
+    pthread_mutex_lock( &cache->lock );
+    i = cache_fetch( cache, block, 1 );
+
+    if( i >= 0 )
+    {
+        memcpy( buf, cache->buffers[i].data, cache->blockSize );
+    }
+
+    pthread_mutex_unlock( &cache->lock );
+
+    return ( i < 0 ) ? -1 : 0;
+}
+
+
+
+/**
+ * Method: Copies a whole block into the cache and marks it dirty; it
+ *  reaches the disk when it is evicted or flushed, so repeated
+ *  writes to the same block cost one disk write
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int block - the block number
+ * @param: char * buf - the block contents
+ *
+ * Return: int
+ */
+int cache_write( cache_t * cache, int block, char * buf )
+{
+    int i;
+
+    if( cache->numBuffers == 0 )
+    {
+        return disk_write( cache->disk, block, buf );
+    }
+
+    if( block < 0 || block >= cache->disk->blockCount )
+    {
+        printf( "disk_write error\n" );
+
+        return -1;
+    }
+
+    pthread_mutex_lock( &cache->lock );
+    i = cache_fetch( cache, block, 0 );
+
+    if( i >= 0 )
+    {
+        memcpy( cache->buffers[i].data, buf, cache->blockSize );
+        cache->buffers[i].dirty = 1;
+    }
+
+    pthread_mutex_unlock( &cache->lock );
+
+    return ( i < 0 ) ? -1 : 0;
+}
+
+
+
+/**
+ * Method: Returns the cached copy of a block without copying it;
+ *  the buffer stays pinned until cache_release is called
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int block - the block number
+ *
+ * Return: char * - the block data or NULL on error
+ */
+char * cache_get( cache_t * cache, int block )
+{
+    int i;
+
+    if( cache->numBuffers == 0 || block < 0 || block >= cache->disk->blockCount )
+    {
+        printf( "disk_read error\n" );
+
+        return NULL;
+    }
+
+    pthread_mutex_lock( &cache->lock );
+    i = cache_fetch( cache, block, 1 );
+
+    if( i >= 0 )
+    {
+        cache->buffers[i].pinned++;
+    }
+
+    pthread_mutex_unlock( &cache->lock );
+
+    return ( i < 0 ) ? NULL : cache->buffers[i].data;
+}
+
+
+
+/**
+ * Method: Like cache_get, but only for a block that is already cached;
+ *  a miss does not read the block
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int block - the block number
+ *
+ * Return: char * - the pinned block data or NULL if it is not cached
+ */
+char * cache_find( cache_t * cache, int block )
+{
+    int i;
+
+    if( cache->numBuffers == 0 || block < 0 || block >= cache->disk->blockCount )
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock( &cache->lock );
+
+    if(( i = cache_lookup_idle( cache, block )) >= 0 )
+    {
+        cache->hits++;
+        cache->buffers[i].referenced = 1;
+        cache->buffers[i].pinned++;
+    }
+
+    pthread_mutex_unlock( &cache->lock );
+
+    return ( i < 0 ) ? NULL : cache->buffers[i].data;
+}
+
+
+
+/**
+ * Method: Tells whether a block is in the cache, without touching it
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int block - the block number
+ *
+ * Return: int - 1 if cached
+ */
+int cache_has( cache_t * cache, int block )
+{
+    int found;
+
+    if( cache->numBuffers == 0 || block < 0 || block >= cache->disk->blockCount )
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock( &cache->lock );
+    found = cache_lookup( cache, block ) >= 0;
+    pthread_mutex_unlock( &cache->lock );
+
+    return found;
+}
+
+
+
+/**
+ * Method: Loads up to count consecutive blocks starting at block
+ *  that are not cached yet, reading each run of missing blocks with
+ *  one disk_readv while the lock is dropped. The buffers start out
+ *  referenced, so CLOCK keeps them for a full turn before they can be
+ *  evicted unused
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int block - the first block number
+ * @param: int count - the number of blocks
+ *
+ * Return: int - the number of blocks read
+ */
+int cache_prefetch( cache_t * cache, int block, int count )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int k;
+    int n = 0;
+    int read = 0;
+    int * run;
+    //  char **(s)
+    char ** bufs;
+
+    if( cache->numBuffers == 0 || block < 0 || count <= 0 )
+    {
+        return 0;
+    }
+
+    //  Never let a prefetch push out more than a quarter of the cache
+    if( count > cache->numBuffers / 4 )
+    {
+        count = cache->numBuffers / 4;
+    }
+
+    if( block + count > cache->disk->blockCount )
+    {
+        count = cache->disk->blockCount - block;
+    }
+
+    run = malloc( count * sizeof( int ));
+    bufs = malloc( count * sizeof( char * ));
+
+    if( run == NULL || bufs == NULL )
+    {
+        free( run );
+        free( bufs );
+
+        return 0;
+    }
+
+    pthread_mutex_lock( &cache->lock );
+
+    for( i = 0; i <= count; i++ )
+    {
+        //  Extend the run of missing blocks; buffers stay busy until
+        //  they are filled so neither eviction nor a lookup takes them
+        if( i < count && cache_lookup( cache, block + i ) < 0 && ( k = cache_evict( cache, block + i, 0 )) >= 0 )
+        {
+            cache->buffers[k].busy = 1;
+            cache->buffers[k].referenced = 1;
+            run[n] = k;
+            bufs[n++] = cache->buffers[k].data;
+
+            continue;
+        }
+
+        if( n > 0 )
+        {
+            int failed;
+
+            pthread_mutex_unlock( &cache->lock );
+            failed = disk_readv( cache->disk, block + i - n, bufs, n ) < 0;
+            pthread_mutex_lock( &cache->lock );
+
+            for( k = 0; k < n; k++ )
+            {
+                cache->buffers[run[k]].busy = 0;
+
+                if( failed )
+                {
+                    cache_unhash( cache, run[k] );
+                    cache->buffers[run[k]].block = -1;
+                    cache->buffers[run[k]].referenced = 0;
+                }
+            }
+
+            pthread_cond_broadcast( &cache->done );
+
+            read += failed ? 0 : n;
+            n = 0;
+        }
+    }
+
+    cache->readahead += read;
+    pthread_mutex_unlock( &cache->lock );
+    free( run );
+    free( bufs );
+
+    return read;
+}
+
+
+
+/**
+ * Method: Number of blocks the cache holds
+ *
+ * @param: cache_t * cache - the cache
+ *
+ * Return: int
+ */
+int cache_capacity( cache_t * cache )
+{
+    return cache->numBuffers;
+}
+
+
+
+/**
+ * Method: Unpins a block returned by cache_get
+ *
+ * @param: cache_t * cache - the cache
+ * @param: int block - the block number
+ * @param: int dirty - 1 if the caller changed the block
+ *
+ * Return: None
+ */
+void cache_release( cache_t * cache, int block, int dirty )
+{
+    int i;
+
+    pthread_mutex_lock( &cache->lock );
+    i = cache_lookup( cache, block );
+
+    if( i >= 0 && cache->buffers[i].pinned > 0 )
+    {
+        cache->buffers[i].pinned--;
+
+        if( dirty )
+        {
+            cache->buffers[i].dirty = 1;
+        }
+    }
+
+    pthread_mutex_unlock( &cache->lock );
+}
+
+
+
+/**
+ * Method: qsort comparator that orders buffers by block number
+ *
+ * @param: const void * a - first buffer
+ * @param: const void * b - second buffer
+ *
+ * Return: int
+ */
+int cache_compare( const void * a, const void * b )
+{
+    return ( *( Buffer * const * ) a )->block - ( *( Buffer * const * ) b )->block;
+}
+
+
+
+/**
+ * Method: Writes every dirty buffer back to the disk in block order;
+ *  runs of consecutive dirty blocks go out as one disk_writev, each
+ *  with the lock dropped and its buffers busy. The buffers stay cached
+ *
+ * @param: cache_t * cache - the cache
+ *
+ * Return: int
+ */
+int cache_flush( cache_t * cache )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int k;
+    int run;
+    int failed;
+    int numDirty = 0;
+    int result = 0;
+    //  Buffer **(s)
+    Buffer ** dirty;
+    //  char **(s)
+    char ** data;
+
+    if( cache->numBuffers == 0 )
+    {
+        return 0;
+    }
+
+    dirty = malloc( cache->numBuffers * sizeof( Buffer * ));
+    data = malloc( cache->numBuffers * sizeof( char * ));
+
+    if( dirty == NULL || data == NULL )
+    {
+        free( dirty );
+        free( data );
+
+        return -1;
+    }
+
+    pthread_mutex_lock( &cache->lock );
+
+    //  A pinned buffer may be changing under its holder; it goes out
+    //  with a later flush or when it is evicted
+    for( i = 0; i < cache->numBuffers; i++ )
+    {
+        if( cache->buffers[i].block >= 0 && cache->buffers[i].dirty && !cache->buffers[i].busy && cache->buffers[i].pinned == 0 )
+        {
+            cache->buffers[i].busy = 1;
+            dirty[numDirty++] = &cache->buffers[i];
+        }
+    }
+
+    qsort( dirty, numDirty, sizeof( Buffer * ), cache_compare );
+    pthread_mutex_unlock( &cache->lock );
+
+    for( i = 0; i < numDirty; i += run )
+    {
+        //  Extend the run while the next dirty block follows this one
+        for( run = 0; i + run < numDirty && dirty[i + run]->block == dirty[i]->block + run; run++ )
+        {
+            data[run] = dirty[i + run]->data;
+        }
+
+        failed = disk_writev( cache->disk, dirty[i]->block, data, run ) < 0;
+        pthread_mutex_lock( &cache->lock );
+
+        for( k = 0; k < run; k++ )
+        {
+            dirty[i + k]->busy = 0;
+
+            if( !failed )
+            {
+                dirty[i + k]->dirty = 0;
+                cache->writebacks++;
+            }
+        }
+
+        pthread_cond_broadcast( &cache->done );
+        pthread_mutex_unlock( &cache->lock );
+        result = failed ? -1 : result;
+    }
+
+    free( dirty );
+    free( data );
+
+    return result;
+}
+
+
+
+/**
+ * Method: Prints the cache size and hit / miss counters
+ *
+ * @param: cache_t * cache - the cache
+ *
+ * Return: int
+ */
+int cache_stat( cache_t * cache )
+{
+    long long lookups;
+
+    pthread_mutex_lock( &cache->lock );
+    lookups = cache->hits + cache->misses;
+    printf( "Buffer cache: %d blocks, %lld hits, %lld misses (%.1f%% hit), %lld writebacks, %lld read ahead\n",
+            cache->numBuffers, cache->hits, cache->misses, lookups ? 100.0 * cache->hits / lookups : 0.0, cache->writebacks, cache->readahead );
+    pthread_mutex_unlock( &cache->lock );
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+/********************************************************
+ *  NAME: Alan Guilfoyle
+ *  CLASS: CSCI 4730 - Operating Systems
+ *  PROJECT: 03 - File System Simulator
+ *
+ *  PURPOSE: To implement a simple UNIX-like file system
+ *      simulator in order to understand the hierarchical
+ *      directory and inode structures.
+ *********************************************************/
+
+#ifndef CACHE_H
+#define CACHE_H
+
+//---IMPORT(S)---
+#include <pthread.h>
+#include "disk.h"
+
+//---DEFINITION(S)---
+#define DEFAULT_CACHE_BLOCK 256
+#define MIN_CACHE_BLOCK 16
+
+//One cached disk block
+typedef struct
+{
+        int block;
+        int dirty;
+        int referenced;
+        int pinned;
+        int busy;
+        int next;
+        char * data;
+} Buffer;
+
+//The buffers in front of one disk; hashHead chains buffers by block.
+//  lock covers the buffer headers and counters, a pinned buffer's data
+//  belongs to whoever pinned it. Disk I/O runs without the lock on
+//  busy buffers; whoever needs one waits on done
+typedef struct
+{
+        pthread_mutex_t lock;
+        pthread_cond_t done;
+        Buffer * buffers;
+        int numBuffers;
+        int size;
+        int blockSize;
+        int clockHand;
+        int hashMask;
+        int * hashHead;
+        long long hits;
+        long long misses;
+        long long writebacks;
+        long long readahead;
+        disk_t * disk;
+} cache_t;
+
+//---METHOD INSTANTIATION(S)---
+void cache_setup( cache_t * cache, disk_t * disk );
+int cache_set_size( cache_t * cache, int numBuffer );
+int cache_init( cache_t * cache, int blockSize );
+int cache_destroy( cache_t * cache );
+int cache_read( cache_t * cache, int block, char * buf );
+int cache_write( cache_t * cache, int block, char * buf );
+char * cache_get( cache_t * cache, int block );
+char * cache_find( cache_t * cache, int block );
+int cache_has( cache_t * cache, int block );
+int cache_prefetch( cache_t * cache, int block, int count );
+int cache_capacity( cache_t * cache );
+void cache_release( cache_t * cache, int block, int dirty );
+int cache_flush( cache_t * cache );
+int cache_stat( cache_t * cache );
+
+#endif
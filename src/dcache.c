@@ -0,0 +1,169 @@
+/********************************************************
+ *  NAME: Alan Guilfoyle
+ *  CLASS: CSCI 4730 - Operating Systems
+ *  PROJECT: 03 - File System Simulator
+ *
+ *  PURPOSE: To implement a simple UNIX-like file system
+ *      simulator in order to understand the hierarchical
+ *      directory and inode structures.
+ *********************************************************/
+
+//---IMPORT(S)---
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "fs.h"
+#include "dcache.h"
+
+/**
+ * Method: The slot a (directory, name) pair maps to; FNV-1a over the
+ *  directory's inode and the name's 16 byte lane
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int parent - the directory's inode
+ * @param: char * key - the name, NUL padded to MAX_FILE_NAME bytes
+ *
+ * Return: DcacheEntry *
+ */
+DcacheEntry * dcache_slot( fs_t * fs, int parent, char * key )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    unsigned int hash = 2166136261u;
+    
+    for( i = 0; i < ( int ) sizeof( int ); i++ )
+    {
+        hash = ( hash ^ (( parent >> ( i * 8 )) & 0xFF )) * 16777619u;
+    }
+    
+    for( i = 0; i < MAX_FILE_NAME && key[i] != '\0'; i++ )
+    {
+        hash = ( hash ^ ( unsigned char ) key[i] ) * 16777619u;
+    }
+    
+    return &fs->dcache[hash & ( DCACHE_ENTRY - 1 )];
+}
+
+
+
+/**
+ * Method: Looks a name up in the dentry cache
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int parent - the directory's inode
+ * @param: char * key - the name, NUL padded to MAX_FILE_NAME bytes
+ * @param: int * inodeNum - set to the name's inode, -1 if the name is
+ *      known not to exist
+ *
+ * Return: int - 1 on a hit, 0 if the directory has to be searched
+ */
+int dcache_lookup( fs_t * fs, int parent, char * key, int * inodeNum )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int hit;
+    //  DcacheEntry *(s)
+    DcacheEntry * entry = dcache_slot( fs, parent, key );
+    
+    //  Lookups only read the table, so they share the lock
+    pthread_rwlock_rdlock( &fs->dcacheLock );
+    
+    if(( hit = ( entry->valid && entry->parent == parent && memcmp( entry->name, key, MAX_FILE_NAME ) == 0 )))
+    {
+        *inodeNum = entry->inode;
+    }
+    
+    pthread_rwlock_unlock( &fs->dcacheLock );
+    __atomic_add_fetch( hit ? &fs->dcacheHits : &fs->dcacheMisses, 1, __ATOMIC_RELAXED );
+    
+    return hit;
+}
+
+
+
+/**
+ * Method: Records what a name in a directory is; the pair replaces
+ *  whatever was in its slot
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int parent - the directory's inode
+ * @param: char * key - the name, NUL padded to MAX_FILE_NAME bytes
+ * @param: int inodeNum - the name's inode, -1 if it does not exist
+ *
+ * Return: None
+ */
+void dcache_set( fs_t * fs, int parent, char * key, int inodeNum )
+{
+    DcacheEntry * entry = dcache_slot( fs, parent, key );
+    
+    pthread_rwlock_wrlock( &fs->dcacheLock );
+    entry->parent = parent;
+    entry->inode = inodeNum;
+    entry->valid = 1;
+    memcpy( entry->name, key, MAX_FILE_NAME );
+    pthread_rwlock_unlock( &fs->dcacheLock );
+}
+
+
+
+/**
+ * Method: Forgets every name of a directory; used when its inode is
+ *  given to a new directory
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int parent - the directory's inode
+ *
+ * Return: None
+ */
+void dcache_drop_dir( fs_t * fs, int parent )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    
+    pthread_rwlock_wrlock( &fs->dcacheLock );
+    
+    for( i = 0; i < DCACHE_ENTRY; i++ )
+    {
+        if( fs->dcache[i].parent == parent )
+        {
+            fs->dcache[i].valid = 0;
+        }
+    }
+    
+    pthread_rwlock_unlock( &fs->dcacheLock );
+}
+
+
+
+/**
+ * Method: Forgets every name; called when the disk is unmounted
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Return: None
+ */
+void dcache_reset( fs_t * fs )
+{
+    memset( fs->dcache, 0, sizeof( fs->dcache ));
+}
+
+
+
+/**
+ * Method: Prints the dentry cache hit and miss counters
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Return: None
+ */
+void dcache_stat( fs_t * fs )
+{
+    long long hits = __atomic_load_n( &fs->dcacheHits, __ATOMIC_RELAXED );
+    long long misses = __atomic_load_n( &fs->dcacheMisses, __ATOMIC_RELAXED );
+    long long lookups = hits + misses;
+    
+    printf( "Dentry cache: %d entries, %lld hits, %lld misses (%.1f%% hit)\n",
+            DCACHE_ENTRY, hits, misses, lookups ? 100.0 * hits / lookups : 0.0 );
+}
@@ -0,0 +1,34 @@
+/********************************************************
+ *  NAME: Alan Guilfoyle
+ *  CLASS: CSCI 4730 - Operating Systems
+ *  PROJECT: 03 - File System Simulator
+ *
+ *  PURPOSE: To implement a simple UNIX-like file system
+ *      simulator in order to understand the hierarchical
+ *      directory and inode structures.
+ *********************************************************/
+
+#ifndef DCACHE_H
+#define DCACHE_H
+
+//---DEFINITION(S)---
+#define DCACHE_ENTRY 4096
+
+//What a name in a directory was last found to be, kept in memory only;
+//  inode is -1 for a name that does not exist
+typedef struct
+{
+        int parent;
+        int inode;
+        int valid;
+        char name[MAX_FILE_NAME];
+} DcacheEntry;
+
+//---METHOD INSTANTIATION(S)---
+int dcache_lookup( fs_t * fs, int parent, char * key, int * inodeNum );
+void dcache_set( fs_t * fs, int parent, char * key, int inodeNum );
+void dcache_drop_dir( fs_t * fs, int parent );
+void dcache_reset( fs_t * fs );
+void dcache_stat( fs_t * fs );
+
+#endif
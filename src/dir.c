@@ -0,0 +1,1441 @@
+/********************************************************
+ *  NAME: Alan Guilfoyle
+ *  CLASS: CSCI 4730 - Operating Systems
+ *  PROJECT: 03 - File System Simulator
+ *
+ *  PURPOSE: To implement a simple UNIX-like file system
+ *      simulator in order to understand the hierarchical
+ *      directory and inode structures.
+ *********************************************************/
+
+//---IMPORT(S)---
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "fs.h"
+#include "fs_util.h"
+#include "cache.h"
+#include "bmap.h"
+#include "dir.h"
+#include "dcache.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define DIR_X86
+#endif
+
+//---GLOBAL VARIABLE(S)---
+//FUNCTION(S)
+int ( * dirScan )( DirView *, char *, unsigned int ) = NULL;
+//PTHREAD_ONCE(S)
+pthread_once_t dirScanOnce = PTHREAD_ONCE_INIT;
+
+
+
+/**
+ * Method: FNV-1a hash of a directory entry name
+ *
+ * @param: char * name - the name, at most MAX_FILE_NAME bytes
+ *
+ * Return: unsigned int
+ */
+unsigned int dir_hash( char * name )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    unsigned int hash = 2166136261u;
+    
+    for( i = 0; i < MAX_FILE_NAME && name[i] != '\0'; i++ )
+    {
+        hash = ( hash ^ ( unsigned char ) name[i] ) * 16777619u;
+    }
+    
+    return hash;
+}
+
+
+
+/**
+ * Method: Tells whether a name is "." or "..", which always stay in
+ *  the directory's first leaf and are not placed by hash
+ *
+ * @param: char * name - the name
+ *
+ * Return: int
+ */
+int dir_is_dot( char * name )
+{
+    return strcmp( name, "." ) == 0 || strcmp( name, ".." ) == 0;
+}
+
+
+
+/**
+ * Method: Physical block of one of a directory's blocks
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: int logical - the block within the directory
+ *
+ * Return: int
+ */
+int dir_block( fs_t * fs, int dirInode, int logical )
+{
+    return bmap_get( fs, dirInode, logical );
+}
+
+
+
+/**
+ * Method: Adds a zeroed block to the end of a directory, next to
+ *  its last block when that one is free
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ *
+ * Return: int - the new logical block or -1 if the disk is full
+ */
+int dir_new_block( fs_t * fs, int dirInode )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int got;
+    int block;
+    int logical = fs->inode[dirInode].blockCount;
+    int goal = ( logical > 0 ) ? dir_block( fs, dirInode, logical - 1 ) + 1 : -1;
+    //  The block and any indirect block it needs
+    int reserved = 1 + bmap_meta_blocks( fs, logical + 1 ) - bmap_meta_blocks( fs, logical );
+    //  char *(s)
+    char * zero;
+    
+    if( reserve_blocks( fs, reserved ) < 0 )
+    {
+        return -1;
+    }
+    
+    if(( block = alloc_extent( fs, goal, 1, &got )) < 0 )
+    {
+        unreserve_blocks( fs, reserved );
+        
+        return -1;
+    }
+    
+    zero = calloc( fs->superBlock.blockSize, 1 );
+    
+    if( zero == NULL || cache_write( &fs->cache, block, zero ) < 0 || bmap_set( fs, dirInode, logical, block ) < 0 )
+    {
+        free( zero );
+        put_free_block( fs, block );
+        unreserve_blocks( fs, reserved );
+        
+        return -1;
+    }
+    
+    free( zero );
+    unreserve_blocks( fs, reserved );
+    fs->inode[dirInode].blockCount++;
+    dirty_inode( fs, dirInode );
+    
+    return logical;
+}
+
+
+
+/**
+ * Method: Number of entries that fit in one index node
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Return: int
+ */
+int htree_cap( fs_t * fs )
+{
+    return ( fs->superBlock.blockSize - sizeof( HtreeNode )) / sizeof( HtreeEntry );
+}
+
+
+
+/**
+ * Method: Follows the index from the root to the leaf whose hash
+ *  range holds hash, recording the entry taken in each node
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: unsigned int hash - the name hash
+ * @param: HtreePath * path - filled with the nodes visited
+ * @param: int * depth - set to the number of nodes visited
+ *
+ * Return: int - the leaf's logical block or -1 on a corrupt index
+ */
+int htree_walk( fs_t * fs, int dirInode, unsigned int hash, HtreePath * path, int * depth )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int logical = HTREE_ROOT;
+    int block;
+    int level;
+    int lo;
+    int hi;
+    int mid;
+    //  HtreeNode *(s)
+    HtreeNode * node;
+    
+    *depth = 0;
+    
+    if( !( fs->inode[dirInode].flags & INODE_HTREE ))
+    {
+        return 0;
+    }
+    
+    while( *depth < HTREE_DEPTH )
+    {
+        block = dir_block( fs, dirInode, logical );
+        
+        if( block == 0 || ( node = ( HtreeNode * ) cache_get( &fs->cache, block )) == NULL )
+        {
+            return -1;
+        }
+        
+        if( node->magic != HTREE_MAGIC || node->count < 1 )
+        {
+            cache_release( &fs->cache, block, 0 );
+            
+            return -1;
+        }
+        
+        //  Last entry whose hash is not above the one looked for
+        lo = 0;
+        hi = node->count - 1;
+        
+        while( lo < hi )
+        {
+            mid = ( lo + hi + 1 ) / 2;
+            
+            if( node->entry[mid].hash <= hash )
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid - 1;
+            }
+        }
+        
+        path[*depth].block = logical;
+        path[*depth].index = lo;
+        ( *depth )++;
+        logical = node->entry[lo].block;
+        level = node->level;
+        cache_release( &fs->cache, block, 0 );
+        
+        if( level == 0 )
+        {
+            return logical;
+        }
+    }
+    
+    return -1;
+}
+
+
+
+/**
+ * Method: Inserts an entry into an index node that has room for it
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: int logical - the index node
+ * @param: int pos - where the entry goes
+ * @param: unsigned int hash - the first hash of the child
+ * @param: int child - the child's logical block
+ *
+ * Return: int
+ */
+int htree_insert( fs_t * fs, int dirInode, int logical, int pos, unsigned int hash, int child )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int block = dir_block( fs, dirInode, logical );
+    //  HtreeNode *(s)
+    HtreeNode * node = ( HtreeNode * ) cache_get( &fs->cache, block );
+    
+    if( node == NULL )
+    {
+        return -1;
+    }
+    
+    memmove( &node->entry[pos + 1], &node->entry[pos], ( node->count - pos ) * sizeof( HtreeEntry ));
+    node->entry[pos].hash = hash;
+    node->entry[pos].block = child;
+    node->count++;
+    cache_release( &fs->cache, block, 1 );
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Makes room in the index node at depth d of a path. A full
+ *  root moves its entries to a new child and gains a level; any other
+ *  full node gives its upper half to a new sibling, once its parent
+ *  has room for the sibling
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: HtreePath * path - the path from htree_walk
+ * @param: int d - the depth of the node
+ *
+ * Return: int - 0 if the node had room, 1 if the index changed and
+ *      the path has to be walked again, -1 if the index can not grow
+ */
+int htree_room( fs_t * fs, int dirInode, HtreePath * path, int d )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int block = dir_block( fs, dirInode, path[d].block );
+    int sibling;
+    int half;
+    int result;
+    //  unsigned int(s)
+    unsigned int split;
+    //  HtreeNode *(s)
+    HtreeNode * node = ( HtreeNode * ) cache_get( &fs->cache, block );
+    HtreeNode * other;
+    
+    if( node == NULL )
+    {
+        return -1;
+    }
+    
+    if( node->count < htree_cap( fs ))
+    {
+        cache_release( &fs->cache, block, 0 );
+        
+        return 0;
+    }
+    
+    if( d == 0 ) //IF: The root is full, push its entries down a level
+    {
+        if( node->level + 1 >= HTREE_DEPTH || ( sibling = dir_new_block( fs, dirInode )) < 0 )
+        {
+            cache_release( &fs->cache, block, 0 );
+            
+            return -1;
+        }
+        
+        other = ( HtreeNode * ) cache_get( &fs->cache, dir_block( fs, dirInode, sibling ));
+        
+        if( other == NULL )
+        {
+            cache_release( &fs->cache, block, 0 );
+            
+            return -1;
+        }
+        
+        memcpy( other, node, fs->superBlock.blockSize );
+        other->entries = 0;
+        cache_release( &fs->cache, dir_block( fs, dirInode, sibling ), 1 );
+        
+        node->level++;
+        node->count = 1;
+        node->entry[0].hash = 0;
+        node->entry[0].block = sibling;
+        cache_release( &fs->cache, block, 1 );
+        
+        return 1;
+    }
+    
+    cache_release( &fs->cache, block, 0 );
+    
+    //  The parent needs room for the new sibling first
+    if(( result = htree_room( fs, dirInode, path, d - 1 )) != 0 )
+    {
+        return result;
+    }
+    
+    if(( sibling = dir_new_block( fs, dirInode )) < 0 )
+    {
+        return -1;
+    }
+    
+    node = ( HtreeNode * ) cache_get( &fs->cache, block );
+    other = ( HtreeNode * ) cache_get( &fs->cache, dir_block( fs, dirInode, sibling ));
+    
+    if( node == NULL || other == NULL )
+    {
+        cache_release( &fs->cache, block, 0 );
+        cache_release( &fs->cache, dir_block( fs, dirInode, sibling ), 0 );
+        
+        return -1;
+    }
+    
+    half = node->count / 2;
+    other->magic = HTREE_MAGIC;
+    other->level = node->level;
+    other->count = node->count - half;
+    other->entries = 0;
+    memcpy( other->entry, &node->entry[half], other->count * sizeof( HtreeEntry ));
+    node->count = half;
+    split = other->entry[0].hash;
+    
+    cache_release( &fs->cache, block, 1 );
+    cache_release( &fs->cache, dir_block( fs, dirInode, sibling ), 1 );
+    
+    if( htree_insert( fs, dirInode, path[d - 1].block, path[d - 1].index + 1, split, sibling ) < 0 )
+    {
+        return -1;
+    }
+    
+    return 1;
+}
+
+
+
+/**
+ * Method: Threads a leaf's free slots into its free list, lowest slot
+ *  first. A free slot's inode field holds the next free slot plus one,
+ *  0 ending the list, and freeSlot holds the first one plus one
+ *
+ * @param: Dentry * leaf - the leaf
+ *
+ * Return: None
+ */
+void dir_free_build( Dentry * leaf )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int head = 0;
+    
+    for( i = MAX_DIR_ENTRY - 1; i >= 0; i-- )
+    {
+        if( leaf->dentry[i].name[0] == '\0' )
+        {
+            leaf->dentry[i].inode = head;
+            head = i + 1;
+        }
+    }
+    
+    leaf->freeSlot = head;
+}
+
+
+
+/**
+ * Method: Takes a free slot off a leaf's free list. A leaf that is
+ *  not full but has no list was written before the list existed, and
+ *  gets one first
+ *
+ * @param: Dentry * leaf - the leaf
+ *
+ * Return: int - the slot or -1 if the leaf is full
+ */
+int dir_slot_take( Dentry * leaf )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int slot;
+    
+    if( leaf->numEntry >= MAX_DIR_ENTRY )
+    {
+        return -1;
+    }
+    
+    if( leaf->freeSlot <= 0 || leaf->freeSlot > MAX_DIR_ENTRY || leaf->dentry[leaf->freeSlot - 1].name[0] != '\0' )
+    {
+        dir_free_build( leaf );
+        
+        if( leaf->freeSlot == 0 )
+        {
+            return -1;
+        }
+    }
+    
+    slot = leaf->freeSlot - 1;
+    leaf->freeSlot = leaf->dentry[slot].inode;
+    
+    return slot;
+}
+
+
+
+/**
+ * Method: Clears a slot and puts it at the head of the leaf's free list
+ *
+ * @param: Dentry * leaf - the leaf
+ * @param: int slot - the slot
+ *
+ * Return: None
+ */
+void dir_slot_give( Dentry * leaf, int slot )
+{
+    memset( &leaf->dentry[slot], 0, sizeof( DirectoryEntry ));
+    leaf->dentry[slot].inode = leaf->freeSlot;
+    leaf->freeSlot = slot + 1;
+    leaf->numEntry--;
+}
+
+
+
+/**
+ * Method: Copies a name into a zeroed 16 byte lane, cut to
+ *  MAX_FILE_NAME - 1 bytes as dir_add stores it, and hashes the lane
+ *
+ * @param: char * name - the name
+ * @param: char * key - the MAX_FILE_NAME byte lane to fill
+ *
+ * Return: unsigned int - the name's hash
+ */
+unsigned int dir_key( char * name, char * key )
+{
+    //---VARIABLE(S)---
+    //  size_t(s)
+    size_t len = strnlen( name, MAX_FILE_NAME - 1 );
+    
+    //  The lane always ends in at least one NUL
+    memset( key, 0, MAX_FILE_NAME );
+    memcpy( key, name, len );
+    
+    return dir_hash( key );
+}
+
+
+
+/**
+ * Method: Copies one slot of a leaf into a view
+ *
+ * @param: DirView * view - the view
+ * @param: int slot - the slot
+ * @param: DirectoryEntry * entry - the slot's entry, NULL for a lane
+ *      past the end of the leaf
+ *
+ * Return: None
+ */
+void dir_view_slot( DirView * view, int slot, DirectoryEntry * entry )
+{
+    if( entry == NULL || entry->name[0] == '\0' )
+    {
+        memset( view->name[slot], 0, MAX_FILE_NAME );
+        view->tag[slot] = 0;
+        view->inode[slot] = 0;
+        
+        return;
+    }
+    
+    view->tag[slot] = dir_key( entry->name, view->name[slot] );
+    view->inode[slot] = entry->inode;
+}
+
+
+
+/**
+ * Method: Lays a leaf's names out in a view
+ *
+ * @param: DirView * view - the view
+ * @param: Dentry * leaf - the leaf
+ *
+ * Return: None
+ */
+void dir_view_fill( DirView * view, Dentry * leaf )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    
+    for( i = 0; i < DIR_LANES; i++ )
+    {
+        dir_view_slot( view, i, ( i < MAX_DIR_ENTRY ) ? &leaf->dentry[i] : NULL );
+    }
+}
+
+
+
+/**
+ * Method: Finds the view of a directory leaf and locks it, laying it
+ *  out from the leaf block when it is not there; views are direct
+ *  mapped by directory and leaf. A view that is there is read locked;
+ *  a missing one is laid out and returned write locked, with the leaf
+ *  read before the lock is taken. The caller unlocks the view
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: int logical - the leaf
+ *
+ * Return: DirView * - the view or NULL if the leaf can not be read
+ */
+DirView * dir_view( fs_t * fs, int dirInode, int logical )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int block;
+    //  DirView *(s)
+    DirView * view = &fs->dirView[( dirInode * 31 + logical ) & ( DIR_VIEW - 1 )];
+    //  Dentry *(s)
+    Dentry * leaf;
+    
+    pthread_rwlock_rdlock( &view->lock );
+    
+    if( view->valid && view->dirInode == dirInode && view->logical == logical )
+    {
+        return view;
+    }
+    
+    pthread_rwlock_unlock( &view->lock );
+    
+    //  The leaf is read without the view, so a miss does not hold up
+    //  lookups of the other directories sharing it
+    block = dir_block( fs, dirInode, logical );
+    
+    if( block == 0 || ( leaf = ( Dentry * ) cache_get( &fs->cache, block )) == NULL )
+    {
+        return NULL;
+    }
+    
+    pthread_rwlock_wrlock( &view->lock );
+    dir_view_fill( view, leaf );
+    view->dirInode = dirInode;
+    view->logical = logical;
+    view->valid = 1;
+    cache_release( &fs->cache, block, 0 );
+    
+    return view;
+}
+
+
+
+/**
+ * Method: Updates a slot of a leaf's view, if the leaf has one, after
+ *  the slot changed in the leaf
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: int logical - the leaf
+ * @param: int slot - the slot
+ * @param: DirectoryEntry * entry - the slot's new entry
+ *
+ * Return: None
+ */
+void dir_view_set( fs_t * fs, int dirInode, int logical, int slot, DirectoryEntry * entry )
+{
+    DirView * view = &fs->dirView[( dirInode * 31 + logical ) & ( DIR_VIEW - 1 )];
+    
+    pthread_rwlock_wrlock( &view->lock );
+    
+    if( view->valid && view->dirInode == dirInode && view->logical == logical )
+    {
+        dir_view_slot( view, slot, entry );
+    }
+    
+    pthread_rwlock_unlock( &view->lock );
+}
+
+
+
+/**
+ * Method: Drops the view of a leaf, or of every leaf of a directory
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: int logical - the leaf, -1 for all of them
+ *
+ * Return: None
+ */
+void dir_view_drop( fs_t * fs, int dirInode, int logical )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int first = 0;
+    int last = DIR_VIEW;
+    
+    //  A single leaf can only be in its own slot
+    if( logical >= 0 )
+    {
+        first = ( dirInode * 31 + logical ) & ( DIR_VIEW - 1 );
+        last = first + 1;
+    }
+    
+    for( i = first; i < last; i++ )
+    {
+        DirView * view = &fs->dirView[i];
+        
+        pthread_rwlock_wrlock( &view->lock );
+        
+        if( view->dirInode == dirInode && ( logical < 0 || view->logical == logical ))
+        {
+            view->valid = 0;
+        }
+        
+        pthread_rwlock_unlock( &view->lock );
+    }
+}
+
+
+
+/**
+ * Method: Drops every view; called when the disk is unmounted
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Return: None
+ */
+void dir_view_reset( fs_t * fs )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    
+    //  The views keep their locks
+    for( i = 0; i < DIR_VIEW; i++ )
+    {
+        fs->dirView[i].dirInode = 0;
+        fs->dirView[i].logical = 0;
+        fs->dirView[i].valid = 0;
+    }
+}
+
+
+
+/**
+ * Method: Picks the fastest scan this CPU has; run once, before the
+ *  first lookup
+ *
+ * @param: None
+ *
+ * Return: None
+ */
+void dir_scan_select()
+{
+    dirScan = dir_scan_has_avx2() ? dir_scan_avx2 : dir_scan_sse2;
+}
+
+
+
+/**
+ * Method: Finds a name in a view one slot at a time
+ *
+ * @param: DirView * view - the view
+ * @param: char * key - the name's lane from dir_key
+ * @param: unsigned int tag - the name's hash
+ *
+ * Return: int - the slot or -1
+ */
+int dir_scan_scalar( DirView * view, char * key, unsigned int tag )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    
+    for( i = 0; i < DIR_LANES; i++ )
+    {
+        if( view->tag[i] == tag && memcmp( view->name[i], key, MAX_FILE_NAME ) == 0 )
+        {
+            return i;
+        }
+    }
+    
+    return -1;
+}
+
+
+
+#ifdef DIR_X86
+/**
+ * Method: Finds a name in a view with SSE2: the tags of 4 slots are
+ *  compared at once and a slot whose tag matches has its whole lane
+ *  compared in one instruction
+ *
+ * @param: DirView * view - the view
+ * @param: char * key - the name's lane from dir_key
+ * @param: unsigned int tag - the name's hash
+ *
+ * Return: int - the slot or -1
+ */
+int dir_scan_sse2( DirView * view, char * key, unsigned int tag )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int j;
+    int mask;
+    //  __m128i(s)
+    __m128i k = _mm_loadu_si128(( __m128i * ) key );
+    __m128i t = _mm_set1_epi32(( int ) tag );
+    
+    for( i = 0; i < DIR_LANES; i += 4 )
+    {
+        mask = _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_load_si128(( __m128i * ) &view->tag[i] ), t )));
+        
+        while( mask )
+        {
+            j = i + __builtin_ctz( mask );
+            
+            if( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_load_si128(( __m128i * ) view->name[j] ), k )) == 0xFFFF )
+            {
+                return j;
+            }
+            
+            mask &= mask - 1;
+        }
+    }
+    
+    return -1;
+}
+
+
+
+/**
+ * Method: Finds a name in a view with AVX2, comparing the tags of 8
+ *  slots at once; only called when the CPU has AVX2
+ *
+ * @param: DirView * view - the view
+ * @param: char * key - the name's lane from dir_key
+ * @param: unsigned int tag - the name's hash
+ *
+ * Return: int - the slot or -1
+ */
+__attribute__(( target( "avx2" )))
+int dir_scan_avx2( DirView * view, char * key, unsigned int tag )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int j;
+    int mask;
+    //  __m128i(s)
+    __m128i k = _mm_loadu_si128(( __m128i * ) key );
+    //  __m256i(s)
+    __m256i t = _mm256_set1_epi32(( int ) tag );
+    
+    for( i = 0; i < DIR_LANES; i += 8 )
+    {
+        mask = _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpeq_epi32( _mm256_load_si256(( __m256i * ) &view->tag[i] ), t )));
+        
+        while( mask )
+        {
+            j = i + __builtin_ctz( mask );
+            
+            if( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_load_si128(( __m128i * ) view->name[j] ), k )) == 0xFFFF )
+            {
+                return j;
+            }
+            
+            mask &= mask - 1;
+        }
+    }
+    
+    return -1;
+}
+
+
+
+/**
+ * Method: Tells whether the CPU can run dir_scan_avx2
+ *
+ * @param: None
+ *
+ * Return: int
+ */
+int dir_scan_has_avx2()
+{
+    return __builtin_cpu_supports( "avx2" );
+}
+#else
+//  Without x86 SIMD both scans fall back to the scalar one
+int dir_scan_sse2( DirView * view, char * key, unsigned int tag )
+{
+    return dir_scan_scalar( view, key, tag );
+}
+
+
+
+int dir_scan_avx2( DirView * view, char * key, unsigned int tag )
+{
+    return dir_scan_scalar( view, key, tag );
+}
+
+
+
+int dir_scan_has_avx2()
+{
+    return 0;
+}
+#endif
+
+
+
+/**
+ * Method: Turns a directory whose only leaf is full into an indexed
+ *  one: a root at HTREE_ROOT with a single entry for the whole range
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ *
+ * Return: int
+ */
+int htree_create( fs_t * fs, int dirInode )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int root;
+    int entries;
+    //  Dentry *(s)
+    Dentry * leaf;
+    //  HtreeNode *(s)
+    HtreeNode * node;
+    
+    if( fs->inode[dirInode].blockCount != HTREE_ROOT || ( leaf = ( Dentry * ) cache_get( &fs->cache, dir_block( fs, dirInode, 0 ))) == NULL )
+    {
+        return -1;
+    }
+    
+    entries = leaf->numEntry;
+    cache_release( &fs->cache, dir_block( fs, dirInode, 0 ), 0 );
+    
+    if(( root = dir_new_block( fs, dirInode )) != HTREE_ROOT || ( node = ( HtreeNode * ) cache_get( &fs->cache, dir_block( fs, dirInode, root ))) == NULL )
+    {
+        return -1;
+    }
+    
+    node->magic = HTREE_MAGIC;
+    node->level = 0;
+    node->count = 1;
+    node->entries = entries;
+    node->entry[0].hash = 0;
+    node->entry[0].block = 0;
+    cache_release( &fs->cache, dir_block( fs, dirInode, root ), 1 );
+    
+    fs->inode[dirInode].flags |= INODE_HTREE;
+    dirty_inode( fs, dirInode );
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Splits a full leaf by hash: the entries hashing above the
+ *  middle move to a new leaf that the parent index node points at.
+ *  Entries with the same hash are never split apart
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: HtreePath * path - the path from htree_walk
+ * @param: int depth - the number of nodes in the path
+ * @param: int logical - the full leaf
+ *
+ * Return: int - 1 once split, -1 if the leaf can not be split
+ */
+int htree_split_leaf( fs_t * fs, int dirInode, HtreePath * path, int depth, int logical )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int j;
+    int n = 0;
+    int k;
+    int sibling;
+    int result;
+    int block = dir_block( fs, dirInode, logical );
+    int slot[MAX_DIR_ENTRY];
+    //  unsigned int(s)
+    unsigned int hash[MAX_DIR_ENTRY];
+    unsigned int split;
+    //  Dentry *(s)
+    Dentry * leaf;
+    Dentry * other;
+    
+    if(( result = htree_room( fs, dirInode, path, depth - 1 )) != 0 )
+    {
+        return result;
+    }
+    
+    if(( leaf = ( Dentry * ) cache_get( &fs->cache, block )) == NULL )
+    {
+        return -1;
+    }
+    
+    //  Orders the entries by hash
+    for( i = 0; i < MAX_DIR_ENTRY; i++ )
+    {
+        if( leaf->dentry[i].name[0] != '\0' && !dir_is_dot( leaf->dentry[i].name ))
+        {
+            unsigned int h = dir_hash( leaf->dentry[i].name );
+            
+            for( j = n; j > 0 && hash[j - 1] > h; j-- )
+            {
+                hash[j] = hash[j - 1];
+                slot[j] = slot[j - 1];
+            }
+            
+            hash[j] = h;
+            slot[j] = i;
+            n++;
+        }
+    }
+    
+    //  Moves the split point off a run of equal hashes
+    for( k = n / 2; k < n && k > 0 && hash[k - 1] == hash[k]; k++ );
+    
+    if( k == n )
+    {
+        for( k = n / 2; k > 0 && hash[k - 1] == hash[k]; k-- );
+    }
+    
+    cache_release( &fs->cache, block, 0 );
+    
+    if( k == 0 || k == n || ( sibling = dir_new_block( fs, dirInode )) < 0 )
+    {
+        return -1;
+    }
+    
+    leaf = ( Dentry * ) cache_get( &fs->cache, block );
+    other = ( Dentry * ) cache_get( &fs->cache, dir_block( fs, dirInode, sibling ));
+    
+    if( leaf == NULL || other == NULL )
+    {
+        cache_release( &fs->cache, block, 0 );
+        cache_release( &fs->cache, dir_block( fs, dirInode, sibling ), 0 );
+        
+        return -1;
+    }
+    
+    split = hash[k];
+    
+    for( i = k; i < n; i++ )
+    {
+        other->dentry[other->numEntry++] = leaf->dentry[slot[i]];
+        dir_slot_give( leaf, slot[i] );
+    }
+    
+    dir_free_build( other );
+    
+    cache_release( &fs->cache, block, 1 );
+    cache_release( &fs->cache, dir_block( fs, dirInode, sibling ), 1 );
+    dir_view_drop( fs, dirInode, logical );
+    dir_view_drop( fs, dirInode, sibling );
+    
+    if( htree_insert( fs, dirInode, path[depth - 1].block, path[depth - 1].index + 1, split, sibling ) < 0 )
+    {
+        return -1;
+    }
+    
+    return 1;
+}
+
+
+
+/**
+ * Method: Adds n to the entry count kept in the root of an indexed
+ *  directory
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: int n - the change
+ *
+ * Return: None
+ */
+void htree_count( fs_t * fs, int dirInode, int n )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int block;
+    //  HtreeNode *(s)
+    HtreeNode * root;
+    
+    if( !( fs->inode[dirInode].flags & INODE_HTREE ))
+    {
+        return;
+    }
+    
+    block = dir_block( fs, dirInode, HTREE_ROOT );
+    
+    if(( root = ( HtreeNode * ) cache_get( &fs->cache, block )) != NULL )
+    {
+        root->entries += n;
+        cache_release( &fs->cache, block, 1 );
+    }
+}
+
+
+
+/**
+ * Method: Finds the leaf and slot holding a name; the leaf is
+ *  scanned through its view
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: char * name - the name
+ * @param: int * logical - set to the leaf holding the name
+ * @param: int * inodeNum - set to the name's inode
+ *
+ * Return: int - the slot or -1 if there is no such name
+ */
+int dir_find( fs_t * fs, int dirInode, char * name, int * logical, int * inodeNum )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int depth;
+    int slot;
+    //  unsigned int(s)
+    unsigned int tag;
+    //  char(s)
+    char key[MAX_FILE_NAME] __attribute__(( aligned( 16 )));
+    //  HtreePath(s)
+    HtreePath path[HTREE_DEPTH];
+    //  DirView *(s)
+    DirView * view;
+    
+    if( name[0] == '\0' )
+    {
+        return -1;
+    }
+    
+    tag = dir_key( name, key );
+    *logical = 0;
+    
+    if( !dir_is_dot( name ) && ( *logical = htree_walk( fs, dirInode, tag, path, &depth )) < 0 )
+    {
+        return -1;
+    }
+    
+    pthread_once( &dirScanOnce, dir_scan_select );
+    
+    if(( view = dir_view( fs, dirInode, *logical )) == NULL )
+    {
+        return -1;
+    }
+    
+    if(( slot = dirScan( view, key, tag )) >= 0 )
+    {
+        *inodeNum = view->inode[slot];
+    }
+    
+    pthread_rwlock_unlock( &view->lock );
+    
+    return slot;
+}
+
+
+
+/**
+ * Method: Sets up the first leaf of a new directory with its "."
+ *  entry and, unless it is the root, its ".." entry
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the new directory's inode
+ * @param: int parentInode - the parent's inode, -1 for the root
+ *
+ * Return: int
+ */
+int dir_init( fs_t * fs, int dirInode, int parentInode )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int block;
+    //  Dentry *(s)
+    Dentry * leaf;
+    
+    //  Views and names left from a directory that had this inode before
+    dir_view_drop( fs, dirInode, -1 );
+    dcache_drop_dir( fs, dirInode );
+    
+    if( dir_new_block( fs, dirInode ) != 0 )
+    {
+        return -1;
+    }
+    
+    block = dir_block( fs, dirInode, 0 );
+    
+    if(( leaf = ( Dentry * ) cache_get( &fs->cache, block )) == NULL )
+    {
+        return -1;
+    }
+    
+    strcpy( leaf->dentry[0].name, "." );
+    leaf->dentry[0].inode = dirInode;
+    leaf->numEntry = 1;
+    
+    if( parentInode >= 0 )
+    {
+        strcpy( leaf->dentry[1].name, ".." );
+        leaf->dentry[1].inode = parentInode;
+        leaf->numEntry = 2;
+    }
+    
+    dir_free_build( leaf );
+    cache_release( &fs->cache, block, 1 );
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Looks a name up in a directory
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: char * name - the name
+ *
+ * Return: int - the name's inode or -1 if it does not exist
+ */
+int dir_lookup( fs_t * fs, int dirInode, char * name )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int logical;
+    int inodeNum;
+    //  char(s)
+    char key[MAX_FILE_NAME];
+    
+    dir_key( name, key );
+    
+    if( dcache_lookup( fs, dirInode, key, &inodeNum ))
+    {
+        return inodeNum;
+    }
+    
+    if( dir_find( fs, dirInode, name, &logical, &inodeNum ) < 0 )
+    {
+        inodeNum = -1;
+    }
+    
+    dcache_set( fs, dirInode, key, inodeNum );
+    
+    return inodeNum;
+}
+
+
+
+/**
+ * Method: Adds an entry to a directory. A full leaf is split, and a
+ *  directory that outgrows its first block gets an index
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: char * name - the entry's name
+ * @param: int inodeNum - the entry's inode
+ *
+ * Return: int - 0, or -1 if the directory can not grow
+ */
+int dir_add( fs_t * fs, int dirInode, char * name, int inodeNum )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int depth;
+    int logical;
+    int block;
+    //  unsigned int(s)
+    unsigned int tag;
+    //  char(s)
+    char key[MAX_FILE_NAME];
+    //  HtreePath(s)
+    HtreePath path[HTREE_DEPTH];
+    //  Dentry *(s)
+    Dentry * leaf;
+    
+    tag = dir_key( name, key );
+    
+    for( ;; )
+    {
+        if(( logical = htree_walk( fs, dirInode, tag, path, &depth )) < 0 )
+        {
+            return -1;
+        }
+        
+        block = dir_block( fs, dirInode, logical );
+        
+        if( block == 0 || ( leaf = ( Dentry * ) cache_get( &fs->cache, block )) == NULL )
+        {
+            return -1;
+        }
+        
+        if(( i = dir_slot_take( leaf )) >= 0 ) //IF: The leaf has a free slot
+        {
+            memcpy( leaf->dentry[i].name, key, MAX_FILE_NAME );
+            leaf->dentry[i].inode = inodeNum;
+            leaf->numEntry++;
+            dir_view_set( fs, dirInode, logical, i, &leaf->dentry[i] );
+            cache_release( &fs->cache, block, 1 );
+            htree_count( fs, dirInode, 1 );
+            dcache_set( fs, dirInode, key, inodeNum );
+            
+            return 0;
+        }
+        
+        cache_release( &fs->cache, block, 0 );
+        
+        if( depth == 0 ) //IF: The first leaf is full, start an index
+        {
+            if( htree_create( fs, dirInode ) < 0 )
+            {
+                return -1;
+            }
+        }
+        else if( htree_split_leaf( fs, dirInode, path, depth, logical ) < 0 )
+        {
+            return -1;
+        }
+    }
+}
+
+
+
+/**
+ * Method: Removes an entry from a directory; the leaf keeps its block
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: char * name - the entry's name
+ *
+ * Return: int - 0, or -1 if there is no such name
+ */
+int dir_delete( fs_t * fs, int dirInode, char * name )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int logical;
+    int inodeNum;
+    int block;
+    int slot = dir_find( fs, dirInode, name, &logical, &inodeNum );
+    //  char(s)
+    char key[MAX_FILE_NAME];
+    //  Dentry *(s)
+    Dentry * leaf;
+    
+    if( slot < 0 || ( block = dir_block( fs, dirInode, logical )) == 0 || ( leaf = ( Dentry * ) cache_get( &fs->cache, block )) == NULL )
+    {
+        return -1;
+    }
+    
+    dir_slot_give( leaf, slot );
+    dir_view_set( fs, dirInode, logical, slot, &leaf->dentry[slot] );
+    cache_release( &fs->cache, block, 1 );
+    htree_count( fs, dirInode, -1 );
+    dir_key( name, key );
+    dcache_set( fs, dirInode, key, -1 );
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Number of entries in a directory, "." and ".." included
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ *
+ * Return: int
+ */
+int dir_count( fs_t * fs, int dirInode )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int count = 0;
+    int block;
+    //  HtreeNode *(s)
+    HtreeNode * root;
+    
+    if( fs->inode[dirInode].flags & INODE_HTREE )
+    {
+        block = dir_block( fs, dirInode, HTREE_ROOT );
+        
+        if(( root = ( HtreeNode * ) cache_get( &fs->cache, block )) != NULL )
+        {
+            count = root->entries;
+            cache_release( &fs->cache, block, 0 );
+        }
+    }
+    else if(( block = dir_block( fs, dirInode, 0 )) != 0 )
+    {
+        Dentry * leaf = ( Dentry * ) cache_get( &fs->cache, block );
+        
+        if( leaf != NULL )
+        {
+            count = leaf->numEntry;
+            cache_release( &fs->cache, block, 0 );
+        }
+    }
+    
+    return count;
+}
+
+
+
+/**
+ * Method: Appends the leaves under an index node, in hash order
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: int logical - the index node
+ * @param: int * leaves - where the leaves' logical blocks go
+ * @param: int n - the number of leaves already found
+ *
+ * Return: int - the number of leaves found
+ */
+int htree_collect( fs_t * fs, int dirInode, int logical, int * leaves, int n )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int block = dir_block( fs, dirInode, logical );
+    //  HtreeNode *(s)
+    HtreeNode * node = ( HtreeNode * ) cache_get( &fs->cache, block );
+    
+    if( node == NULL )
+    {
+        return n;
+    }
+    
+    for( i = 0; i < node->count && n < fs->inode[dirInode].blockCount; i++ )
+    {
+        if( node->level == 0 )
+        {
+            leaves[n++] = node->entry[i].block;
+        }
+        else
+        {
+            n = htree_collect( fs, dirInode, node->entry[i].block, leaves, n );
+        }
+    }
+    
+    cache_release( &fs->cache, block, 0 );
+    
+    return n;
+}
+
+
+
+/**
+ * Method: Lists a directory's leaves in hash order, so a listing
+ *  keeps the same order as long as the directory does not change;
+ *  the first leaf, with "." and "..", always comes first
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory's inode
+ * @param: int ** leaves - set to a malloc'd array of logical blocks
+ *
+ * Return: int - the number of leaves or -1 if out of memory
+ */
+int dir_leaves( fs_t * fs, int dirInode, int ** leaves )
+{
+    if(( *leaves = malloc(( fs->inode[dirInode].blockCount + 1 ) * sizeof( int ))) == NULL )
+    {
+        return -1;
+    }
+    
+    if( !( fs->inode[dirInode].flags & INODE_HTREE ))
+    {
+        ( *leaves )[0] = 0;
+        
+        return 1;
+    }
+    
+    return htree_collect( fs, dirInode, HTREE_ROOT, *leaves, 0 );
+}
@@ -0,0 +1,83 @@
+/********************************************************
+ *  NAME: Alan Guilfoyle
+ *  CLASS: CSCI 4730 - Operating Systems
+ *  PROJECT: 03 - File System Simulator
+ *
+ *  PURPOSE: To implement a simple UNIX-like file system
+ *      simulator in order to understand the hierarchical
+ *      directory and inode structures.
+ *********************************************************/
+
+#ifndef DIR_H
+#define DIR_H
+
+//---DEFINITION(S)---
+#define HTREE_MAGIC 0x48545245
+#define HTREE_ROOT 1
+#define HTREE_DEPTH 4
+#define DIR_LANES 32
+#define DIR_VIEW 64
+
+//One index entry: names hashing to hash or more, up to the next
+//  entry's hash, are found under logical block block of the directory
+typedef struct
+{
+        unsigned int hash;
+        int block;
+} HtreeEntry;
+
+//Index node of a directory with INODE_HTREE; entries are sorted by
+//  hash and the first one has hash 0. level 0 nodes point at leaves,
+//  which are Dentry blocks. Only the root's entries field is used,
+//  it counts every entry of the directory
+typedef struct
+{
+        int magic;
+        int level;
+        int count;
+        int entries;
+        HtreeEntry entry[];
+} HtreeNode;
+
+//The nodes a lookup went through, from the root down
+typedef struct
+{
+        int block;
+        int index;
+} HtreePath;
+
+//The names of one leaf laid out for SIMD scans, kept in memory only:
+//  each name is NUL padded to a 16 byte lane and tag holds its hash, so
+//  one compare tests the tags of 4 (SSE2) or 8 (AVX2) slots. Lanes past
+//  MAX_DIR_ENTRY and free slots are all zeros. lock guards the view,
+//  lookups scan it shared
+typedef struct
+{
+        char name[DIR_LANES][MAX_FILE_NAME] __attribute__(( aligned( 32 )));
+        unsigned int tag[DIR_LANES] __attribute__(( aligned( 32 )));
+        int inode[DIR_LANES];
+        int dirInode;
+        int logical;
+        int valid;
+        pthread_rwlock_t lock;
+} DirView;
+
+//---METHOD INSTANTIATION(S)---
+unsigned int dir_hash( char * name );
+int dir_init( fs_t * fs, int dirInode, int parentInode );
+int dir_lookup( fs_t * fs, int dirInode, char * name );
+int dir_add( fs_t * fs, int dirInode, char * name, int inodeNum );
+int dir_delete( fs_t * fs, int dirInode, char * name );
+int dir_count( fs_t * fs, int dirInode );
+int dir_leaves( fs_t * fs, int dirInode, int ** leaves );
+int dir_block( fs_t * fs, int dirInode, int logical );
+void dir_view_fill( DirView * view, Dentry * leaf );
+void dir_view_reset( fs_t * fs );
+unsigned int dir_key( char * name, char * key );
+int dir_scan_scalar( DirView * view, char * key, unsigned int tag );
+int dir_scan_sse2( DirView * view, char * key, unsigned int tag );
+int dir_scan_avx2( DirView * view, char * key, unsigned int tag );
+int dir_scan_has_avx2();
+void dir_scan_select();
+
+#endif
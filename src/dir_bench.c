@@ -0,0 +1,187 @@
+/********************************************************
+ *  NAME: Alan Guilfoyle
+ *  CLASS: CSCI 4730 - Operating Systems
+ *  PROJECT: 03 - File System Simulator
+ *
+ *  PURPOSE: To implement a simple UNIX-like file system
+ *      simulator in order to understand the hierarchical
+ *      directory and inode structures.
+ *********************************************************/
+
+//---IMPORT(S)---
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdbool.h>
+#include "fs.h"
+#include "dir.h"
+
+//---DEFINITION(S)---
+#define BENCH_ROUNDS 2000000
+
+//---GLOBAL VARIABLE(S)---
+//INT(S)
+volatile int benchSink = 0;
+
+
+
+bool command(char * comm, char * comm2)
+{
+    if( strlen( comm ) == strlen( comm2 ) && strncmp( comm, comm2, strlen( comm )) == 0 )
+    {
+        return true;
+    }
+    
+    return false;
+}
+
+
+
+/**
+ * Method: The lookup search_cur_dir did before directories were
+ *  indexed: every slot is compared with command()
+ *
+ * @param: Dentry * dir - the directory block
+ * @param: char * name - the name to find
+ *
+ * Return: int - the name's inode or -1
+ */
+int bench_linear( Dentry * dir, char * name )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    
+    for( i = 0; i < MAX_DIR_ENTRY; i++ )
+    {
+        if( command( name, dir->dentry[i].name ))
+        {
+            return dir->dentry[i].inode;
+        }
+    }
+    
+    return -1;
+}
+
+
+
+/**
+ * Method: Seconds on the monotonic clock
+ *
+ * @param: None
+ *
+ * Return: double
+ */
+double bench_now()
+{
+    struct timespec ts;
+    
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+
+/**
+ * Method: Times the scans of a full directory leaf; half of the
+ *  lookups are for names that are not there
+ *
+ * @param: int argc - argument count
+ * @param: char ** argv - argv[1] is the number of rounds
+ *
+ * Return: int
+ */
+int main( int argc, char ** argv )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int j;
+    int rounds = ( argc > 1 ) ? atoi( argv[1] ) : BENCH_ROUNDS;
+    int numKey = MAX_DIR_ENTRY * 2;
+    //  unsigned int(s)
+    unsigned int * tags;
+    //  double(s)
+    double start;
+    //  char(s)
+    char ( * names )[MAX_FILE_NAME];
+    char ( * keys )[MAX_FILE_NAME];
+    //  struct(s)
+    static Dentry dir;
+    static DirView view;
+    
+    names = calloc( numKey, MAX_FILE_NAME );
+    keys = aligned_alloc( 16, numKey * MAX_FILE_NAME );
+    tags = malloc( numKey * sizeof( unsigned int ));
+    
+    for( i = 0; i < MAX_DIR_ENTRY; i++ )
+    {
+        snprintf( dir.dentry[i].name, MAX_FILE_NAME, "file%04d", i * 37 );
+        dir.dentry[i].inode = i + 1;
+    }
+    
+    dir.numEntry = MAX_DIR_ENTRY;
+    dir_view_fill( &view, &dir );
+    
+    //  Every other key misses
+    for( i = 0; i < numKey; i++ )
+    {
+        snprintf( names[i], MAX_FILE_NAME, "file%04d", ( i % 2 ) ? i * 37 + 1 : ( i / 2 ) * 37 );
+        tags[i] = dir_key( names[i], keys[i] );
+    }
+    
+    printf( "%d lookups in a %d entry leaf, half of them misses\n", rounds, MAX_DIR_ENTRY );
+    
+    start = bench_now();
+    for( i = 0, j = 0; i < rounds; i++, j = ( j + 1 ) % numKey )
+    {
+        benchSink += bench_linear( &dir, names[j] );
+    }
+    printf( "linear command():  %6.1f ns/lookup\n", ( bench_now() - start ) * 1e9 / rounds );
+    
+    start = bench_now();
+    for( i = 0, j = 0; i < rounds; i++, j = ( j + 1 ) % numKey )
+    {
+        benchSink += dir_scan_scalar( &view, keys[j], tags[j] );
+    }
+    printf( "view, scalar:      %6.1f ns/lookup\n", ( bench_now() - start ) * 1e9 / rounds );
+    
+    start = bench_now();
+    for( i = 0, j = 0; i < rounds; i++, j = ( j + 1 ) % numKey )
+    {
+        benchSink += dir_scan_sse2( &view, keys[j], tags[j] );
+    }
+    printf( "view, SSE2:        %6.1f ns/lookup\n", ( bench_now() - start ) * 1e9 / rounds );
+    
+    if( dir_scan_has_avx2())
+    {
+        start = bench_now();
+        for( i = 0, j = 0; i < rounds; i++, j = ( j + 1 ) % numKey )
+        {
+            benchSink += dir_scan_avx2( &view, keys[j], tags[j] );
+        }
+        printf( "view, AVX2:        %6.1f ns/lookup\n", ( bench_now() - start ) * 1e9 / rounds );
+    }
+    
+    //  Every scan has to agree with the old loop
+    for( j = 0; j < numKey; j++ )
+    {
+        int slot = dir_scan_sse2( &view, keys[j], tags[j] );
+        
+        if(( slot < 0 ? -1 : view.inode[slot] ) != bench_linear( &dir, names[j] ) || slot != dir_scan_scalar( &view, keys[j], tags[j] )
+            || ( dir_scan_has_avx2() && slot != dir_scan_avx2( &view, keys[j], tags[j] )))
+        {
+            printf( "mismatch for %s\n", names[j] );
+            
+            return 1;
+        }
+    }
+    
+    free( names );
+    free( keys );
+    free( tags );
+    
+    return 0;
+}
@@ -8,75 +8,925 @@
  *      directory and inode structures.
  *********************************************************/
 
+#define _GNU_SOURCE
+
 //---IMPORT(S)---
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
 #include "disk.h"
 
-char disk[MAX_BLOCK][BLOCK_SIZE];
+//---DEFINITION(S)---
+#define DIRECT_ALIGN 4096
+
+/**
+ * Method: Sets a disk handle up to be mounted: the memory backend,
+ *  MIN_BLOCK_SIZE blocks and no image
+ *
+ * @param: disk_t * disk - the handle
+ *
+ * Return: None
+ */
+void disk_setup( disk_t * disk )
+{
+    memset( disk, 0, sizeof( disk_t ));
+    disk->backend = DISK_MEMORY;
+    disk->fd = -1;
+    disk->blockSize = MIN_BLOCK_SIZE;
+}
+
+
+
+/**
+ * Method: Reads one block with a positioned read from the image
+ *  file; O_DIRECT needs an aligned buffer, so the block bounces
+ *  through directBuf when the backend is DISK_DIRECT
+ *
+ * @param: disk_t * disk - the disk
+ * @param: int block - the block number to read
+ * @param: char * buf - where the block is copied to
+ *
+ * Return: int
+ */
+int disk_pread( disk_t * disk, int block, char * buf )
+{
+    char * dst = ( disk->backend == DISK_DIRECT ) ? disk->directBuf : buf;
+
+    if( pread( disk->fd, dst, disk->blockSize, ( off_t ) block * disk->blockSize ) != disk->blockSize )
+    {
+        perror( "disk_read" );
+
+        return -1;
+    }
+
+    if( dst != buf )
+    {
+        memcpy( buf, dst, disk->blockSize );
+    }
+
+    return 0;
+}
+
 
 
+/**
+ * Method: Writes one block with a positioned write to the image file
+ *
+ * @param: disk_t * disk - the disk
+ * @param: int block - the block number to write
+ * @param: char * buf - the block contents
+ *
+ * Return: int
+ */
+int disk_pwrite( disk_t * disk, int block, char * buf )
+{
+    char * src = buf;
+
+    if( disk->backend == DISK_DIRECT )
+    {
+        memcpy( disk->directBuf, buf, disk->blockSize );
+        src = disk->directBuf;
+    }
+
+    if( pwrite( disk->fd, src, disk->blockSize, ( off_t ) block * disk->blockSize ) != disk->blockSize )
+    {
+        perror( "disk_write" );
+
+        return -1;
+    }
+
+    return 0;
+}
+
 
-int disk_read( int block, char * buf )
+
+int disk_read( disk_t * disk, int block, char * buf )
 {
-		if( block < 0 || block >= MAX_BLOCK )
+		if( block < 0 || block >= disk->blockCount )
         {
 				printf( "disk_read error\n" );
-				
+
                 return -1;
 		}
-		memcpy( buf, disk[block], BLOCK_SIZE );
-    
+
+        if( disk->backend == DISK_PIO || disk->backend == DISK_DIRECT )
+        {
+                return disk_pread( disk, block, buf );
+        }
+		memcpy( buf, disk->data + (( size_t ) block * disk->blockSize ), disk->blockSize );
+
 		return 0;
 }
 
 
 
-int disk_write( int block, char * buf)
+int disk_write( disk_t * disk, int block, char * buf)
 {
-		if( block < 0 || block >= MAX_BLOCK )
+		if( block < 0 || block >= disk->blockCount )
         {
 				printf( "disk_write error\n" );
-				
+
                 return -1;
 		}
-		memcpy( disk[block], buf, BLOCK_SIZE );
-    
+
+        if( disk->backend == DISK_PIO || disk->backend == DISK_DIRECT )
+        {
+                return disk_pwrite( disk, block, buf );
+        }
+		memcpy( disk->data + (( size_t ) block * disk->blockSize ), buf, disk->blockSize );
+        disk->dirty[block / 8] |= 1 << ( block % 8 );
+
 		return 0;
 }
 
 
 
-int disk_mount( char * name )
+/**
+ * Method: Reads a run of consecutive blocks in one call; the
+ *  file-backed backends issue a single preadv for the whole run
+ *
+ * @param: disk_t * disk - the disk
+ * @param: int block - the first block number
+ * @param: char ** bufs - where each block of the run is copied to
+ * @param: int count - the number of blocks in the run
+ *
+ * Return: int
+ */
+int disk_readv( disk_t * disk, int block, char ** bufs, int count )
 {
-		FILE *fp = fopen( name, "r" );
-		
-        if( fp != NULL )
+    //---VARIABLE(S)---
+    struct iovec iov[IOV_MAX];
+    //  int(s)
+    int i;
+    int n;
+    int done = 0;
+    //  ssize_t(s)
+    ssize_t want;
+
+    if( block < 0 || count < 0 || block + count > disk->blockCount )
+    {
+        printf( "disk_read error\n" );
+
+        return -1;
+    }
+
+    if( disk->backend != DISK_PIO && disk->backend != DISK_DIRECT )
+    {
+        for( i = 0; i < count; i++ )
         {
-				fread( disk, BLOCK_SIZE, MAX_BLOCK, fp );
-				fclose( fp );
-				
-                return 1;
-		}
-    
-		return 0;
+            if( disk_read( disk, block + i, bufs[i] ) < 0 )
+            {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+
+    while( done < count )
+    {
+        n = ( count - done < IOV_MAX ) ? count - done : IOV_MAX;
+
+        for( i = 0; i < n; i++ )
+        {
+            //  O_DIRECT can only fill aligned buffers straight from the image
+            if( disk->backend == DISK_DIRECT && ( uintptr_t ) bufs[done + i] % DIRECT_ALIGN != 0 )
+            {
+                n = i;
+
+                break;
+            }
+
+            iov[i].iov_base = bufs[done + i];
+            iov[i].iov_len = disk->blockSize;
+        }
+
+        if( n == 0 )
+        {
+            if( disk_pread( disk, block + done, bufs[done] ) < 0 )
+            {
+                return -1;
+            }
+
+            done++;
+
+            continue;
+        }
+
+        want = ( ssize_t ) n * disk->blockSize;
+
+        if( preadv( disk->fd, iov, n, ( off_t )( block + done ) * disk->blockSize ) != want )
+        {
+            perror( "disk_read" );
+
+            return -1;
+        }
+
+        done += n;
+    }
+
+    return 0;
 }
 
 
 
-int disk_umount( char * name )
+/**
+ * Method: Writes a run of consecutive blocks in one call; the
+ *  file-backed backends issue a single pwritev for the whole run
+ *
+ * @param: disk_t * disk - the disk
+ * @param: int block - the first block number
+ * @param: char ** bufs - the contents of each block in the run
+ * @param: int count - the number of blocks in the run
+ *
+ * Return: int
+ */
+int disk_writev( disk_t * disk, int block, char ** bufs, int count )
 {
-		FILE * fp = fopen( name, "w" );
-		
-        if( fp == NULL )
+    //---VARIABLE(S)---
+    struct iovec iov[IOV_MAX];
+    //  int(s)
+    int i;
+    int n;
+    int done = 0;
+    //  ssize_t(s)
+    ssize_t want;
+
+    if( block < 0 || count < 0 || block + count > disk->blockCount )
+    {
+        printf( "disk_write error\n" );
+
+        return -1;
+    }
+
+    if( disk->backend != DISK_PIO && disk->backend != DISK_DIRECT )
+    {
+        for( i = 0; i < count; i++ )
         {
-				fprintf( stderr, "disk_umount: file open error! %s\n", name );
-            
-				return -1;
-		}
+            if( disk_write( disk, block + i, bufs[i] ) < 0 )
+            {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+
+    while( done < count )
+    {
+        n = ( count - done < IOV_MAX ) ? count - done : IOV_MAX;
+
+        for( i = 0; i < n; i++ )
+        {
+            //  O_DIRECT can only take aligned buffers straight from the caller
+            if( disk->backend == DISK_DIRECT && ( uintptr_t ) bufs[done + i] % DIRECT_ALIGN != 0 )
+            {
+                n = i;
+
+                break;
+            }
+
+            iov[i].iov_base = bufs[done + i];
+            iov[i].iov_len = disk->blockSize;
+        }
+
+        if( n == 0 )
+        {
+            if( disk_pwrite( disk, block + done, bufs[done] ) < 0 )
+            {
+                return -1;
+            }
+
+            done++;
+
+            continue;
+        }
+
+        want = ( ssize_t ) n * disk->blockSize;
+
+        if( pwritev( disk->fd, iov, n, ( off_t )( block + done ) * disk->blockSize ) != want )
+        {
+            perror( "disk_write" );
+
+            return -1;
+        }
+
+        done += n;
+    }
+
+    return 0;
+}
+
+
+
+/**
+ * Method: Writes every byte described by an iovec array to a host
+ *  descriptor, picking up after short writes
+ *
+ * @param: int fd - the descriptor to write to
+ * @param: struct iovec * iov - the buffers; advanced in place
+ * @param: int count - the number of buffers
+ *
+ * Return: int
+ */
+int disk_write_out( int fd, struct iovec * iov, int count )
+{
+    //---VARIABLE(S)---
+    //  ssize_t(s)
+    ssize_t n;
+
+    while( count > 0 )
+    {
+        n = writev( fd, iov, ( count < IOV_MAX ) ? count : IOV_MAX );
+
+        if( n < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+
+            perror( "disk_write_out" );
+
+            return -1;
+        }
+
+        //  Skip the buffers that went out whole, trim the next one
+        while( count > 0 && ( size_t ) n >= iov->iov_len )
+        {
+            n -= iov->iov_len;
+            iov++;
+            count--;
+        }
+
+        if( count > 0 )
+        {
+            iov->iov_base = ( char * ) iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+
+    return 0;
+}
+
+
+
+/**
+ * Method: Copies bytes of the image starting at a block straight to a
+ *  host descriptor without going through the buffer cache. An image
+ *  held in memory is written from where it sits; a file-backed image
+ *  is moved by the kernel with sendfile, falling back to pread and
+ *  write where the descriptors do not support it
+ *
+ * @param: disk_t * disk - the disk
+ * @param: int fd - the descriptor to write to
+ * @param: int block - the first block
+ * @param: long long bytes - how many bytes to send
+ *
+ * Return: int
+ */
+int disk_send( disk_t * disk, int fd, int block, long long bytes )
+{
+    //---VARIABLE(S)---
+    //  off_t(s)
+    off_t pos = ( off_t ) block * disk->blockSize;
+    //  ssize_t(s)
+    ssize_t n;
+    //  char *(s)
+    char * bounce;
+    //  iovec(s)
+    struct iovec iov;
+
+    if( block < 0 || bytes < 0 || pos + bytes > ( off_t ) disk->blockCount * disk->blockSize )
+    {
+        printf( "disk_read error\n" );
+
+        return -1;
+    }
+
+    if( disk->backend == DISK_MEMORY )
+    {
+        iov.iov_base = disk->data + pos;
+        iov.iov_len = bytes;
+
+        return disk_write_out( fd, &iov, 1 );
+    }
+
+    while( bytes > 0 )
+    {
+        n = sendfile( fd, disk->fd, &pos, ( bytes < INT_MAX ) ? bytes : INT_MAX );
+
+        if( n > 0 )
+        {
+            bytes -= n;
+
+            continue;
+        }
+
+        if( n < 0 && errno == EINTR )
+        {
+            continue;
+        }
+
+        break;
+    }
+
+    if( bytes == 0 )
+    {
+        return 0;
+    }
+
+    //  The output (a terminal, say) or an O_DIRECT image cannot be spliced
+    if( posix_memalign(( void ** ) &bounce, DIRECT_ALIGN, disk->blockSize ) != 0 )
+    {
+        return -1;
+    }
+
+    while( bytes > 0 )
+    {
+        int part = ( bytes < disk->blockSize - pos % disk->blockSize ) ? bytes : disk->blockSize - pos % disk->blockSize;
+
+        if( disk_read( disk, pos / disk->blockSize, bounce ) < 0 )
+        {
+            free( bounce );
+
+            return -1;
+        }
+
+        iov.iov_base = bounce + pos % disk->blockSize;
+        iov.iov_len = part;
+
+        if( disk_write_out( fd, &iov, 1 ) < 0 )
+        {
+            free( bounce );
+
+            return -1;
+        }
+
+        pos += part;
+        bytes -= part;
+    }
+
+    free( bounce );
+
+    return 0;
+}
+
+
+
+/**
+ * Method: Pushes the blocks written since the last sync out to the
+ *  image file. Dirty blocks next to each other go out as one write
+ *  (memory) or one msync (mmap); the positioned I/O backends have
+ *  already written every block and only need an fsync
+ *
+ * @param: disk_t * disk - the disk
+ *
+ * Return: int
+ */
+int disk_sync( disk_t * disk )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int start;
+    int end;
+    int result = 0;
+    long page = sysconf( _SC_PAGESIZE );
+    //  size_t(s)
+    size_t from;
+    size_t to;
+
+    if( disk->backend == DISK_PIO || disk->backend == DISK_DIRECT )
+    {
+        return fsync( disk->fd );
+    }
+
+    //  A new image file is still empty until it is first synced
+    if( disk->backend == DISK_MEMORY && ftruncate( disk->fd, ( off_t ) disk->bytes ) < 0 )
+    {
+        perror( "disk_sync" );
+
+        return -1;
+    }
+
+    for( start = 0; start < disk->blockCount; start++ )
+    {
+        if( disk->dirty[start / 8] == 0 )
+        {
+            start += 7 - start % 8;
+
+            continue;
+        }
+
+        if( !( disk->dirty[start / 8] & ( 1 << ( start % 8 ))))
+        {
+            continue;
+        }
+
+        for( end = start; end < disk->blockCount && ( disk->dirty[end / 8] & ( 1 << ( end % 8 ))); end++ )
+        {
+            disk->dirty[end / 8] &= ~( 1 << ( end % 8 ));
+        }
+
+        from = ( size_t ) start * disk->blockSize;
+        to = ( size_t ) end * disk->blockSize;
+
+        if( disk->backend == DISK_MMAP )
+        {
+            //  msync has to start on a page boundary
+            from -= from % page;
+
+            if( msync( disk->data + from, to - from, MS_SYNC ) < 0 )
+            {
+                perror( "disk_sync" );
+                result = -1;
+            }
+        }
+        else
+        {
+            while( from < to )
+            {
+                ssize_t written = pwrite( disk->fd, disk->data + from, to - from, ( off_t ) from );
+
+                if( written <= 0 )
+                {
+                    perror( "disk_sync" );
+                    result = -1;
+
+                    break;
+                }
+
+                from += written;
+            }
+        }
+
+        start = end;
+    }
+
+    return result;
+}
+
+
+
+/**
+ * Method: Selects how the image is held while mounted; must be
+ *  called before disk_mount
+ *
+ * @param: disk_t * disk - the disk
+ * @param: BACKEND backend - DISK_MEMORY reads the whole image into
+ *      memory and writes it all back on unmount; DISK_MMAP maps the
+ *      image file so blocks are paged in on first touch and only
+ *      dirty pages are written back; DISK_PIO reads and writes each
+ *      block in place in the file and DISK_DIRECT does the same
+ *      with O_DIRECT so the host page cache is bypassed
+ *
+ * Return: int
+ */
+int disk_set_backend( disk_t * disk, BACKEND backend )
+{
+    if( disk->fd >= 0 || disk->data != NULL )
+    {
+        fprintf( stderr, "disk_set_backend: disk is already mounted\n" );
+
+        return -1;
+    }
+
+    disk->backend = backend;
+
+    return 0;
+}
+
+
+
+/**
+ * Method: Sets the block size and block count of the mounted image,
+ *  growing the backing memory or file when the image is too short.
+ *  Until this is called the image is addressed in MIN_BLOCK_SIZE
+ *  blocks, which is enough to read the superblock
+ *
+ * @param: disk_t * disk - the disk
+ * @param: int blockSize - bytes per block
+ * @param: int blockCount - number of blocks on the disk
+ *
+ * Return: int
+ */
+int disk_set_geometry( disk_t * disk, int blockSize, int blockCount )
+{
+    //---VARIABLE(S)---
+    size_t bytes = ( size_t ) blockSize * blockCount;
+    char * grown;
+    unsigned char * dirty;
+    size_t dirtyBytes = (( size_t ) blockCount + 7 ) / 8;
+
+    if( dirtyBytes > disk->dirtyBytes )
+    {
+        dirty = realloc( disk->dirty, dirtyBytes );
+
+        if( dirty == NULL )
+        {
+            fprintf( stderr, "disk_set_geometry: out of memory\n" );
+
+            return -1;
+        }
+
+        memset( dirty + disk->dirtyBytes, 0, dirtyBytes - disk->dirtyBytes );
+        disk->dirty = dirty;
+        disk->dirtyBytes = dirtyBytes;
+    }
+
+    if( bytes > disk->bytes )
+    {
+        if( disk->backend == DISK_MEMORY )
+        {
+            grown = realloc( disk->data, bytes );
+
+            if( grown == NULL )
+            {
+                fprintf( stderr, "disk_set_geometry: out of memory\n" );
+
+                return -1;
+            }
+
+            memset( grown + disk->bytes, 0, bytes - disk->bytes );
+            disk->data = grown;
+        }
+        else
+        {
+            //  Holes read back as zero, so this costs nothing until written
+            if( ftruncate( disk->fd, ( off_t ) bytes ) < 0 )
+            {
+                perror( "disk_set_geometry" );
+
+                return -1;
+            }
+
+            if( disk->backend == DISK_MMAP )
+            {
+                if( disk->data != NULL )
+                {
+                    munmap( disk->data, disk->bytes );
+                }
+
+                grown = mmap( NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, disk->fd, 0 );
+
+                if( grown == MAP_FAILED )
+                {
+                    perror( "disk_set_geometry" );
+                    disk->data = NULL;
+
+                    return -1;
+                }
+
+                disk->data = grown;
+            }
+        }
+
+        disk->bytes = bytes;
+    }
+
+    if( disk->backend == DISK_DIRECT && blockSize != disk->blockSize )
+    {
+        free( disk->directBuf );
+
+        if( posix_memalign(( void ** ) &disk->directBuf, DIRECT_ALIGN, blockSize ) != 0 )
+        {
+            fprintf( stderr, "disk_set_geometry: out of memory\n" );
+            disk->directBuf = NULL;
+
+            return -1;
+        }
+    }
+
+    disk->blockSize = blockSize;
+    disk->blockCount = blockCount;
+
+    return 0;
+}
+
+
+
+/**
+ * Method: Opens the image file for the file-backed backends
+ *
+ * @param: disk_t * disk - the disk
+ * @param: char * name - the image file to open
+ * @param: int flags - extra open flags, such as O_DIRECT
+ *
+ * Return: int - 1 if the image already held data, 0 if it is new
+ *      and -1 on error
+ */
+int disk_open( disk_t * disk, char * name, int flags )
+{
+    //---VARIABLE(S)---
+    struct stat st;
+
+    disk->fd = open( name, O_RDWR | O_CREAT | flags, 0644 );
+
+    //  Not every file system supports O_DIRECT (tmpfs does not)
+    if( disk->fd < 0 && errno == EINVAL && ( flags & O_DIRECT ))
+    {
+        fprintf( stderr, "disk_mount: O_DIRECT not supported for %s, using buffered I/O\n", name );
+        disk->backend = DISK_PIO;
+        disk->fd = open( name, O_RDWR | O_CREAT | ( flags & ~O_DIRECT ), 0644 );
+    }
+
+    if( disk->fd < 0 )
+    {
+        perror( "disk_mount" );
+
+        return -1;
+    }
+
+    if( fstat( disk->fd, &st ) < 0 )
+    {
+        perror( "disk_mount" );
+        close( disk->fd );
+        disk->fd = -1;
+
+        return -1;
+    }
+
+    disk->bytes = st.st_size;
+
+    return disk->bytes > 0;
+}
+
+
+
+/**
+ * Method: Maps the image file shared into memory
+ *
+ * @param: disk_t * disk - the disk
+ * @param: char * name - the image file to map
+ *
+ * Return: int - 1 if the image already held data, 0 if it is new
+ *      and -1 on error
+ */
+int disk_mount_mmap( disk_t * disk, char * name )
+{
+    //---VARIABLE(S)---
+    int existed = disk_open( disk, name, 0 );
+    void * map;
+
+    if( existed <= 0 )
+    {
+        return existed;
+    }
+
+    map = mmap( NULL, disk->bytes, PROT_READ | PROT_WRITE, MAP_SHARED, disk->fd, 0 );
+
+    if( map == MAP_FAILED )
+    {
+        perror( "disk_mount" );
+        close( disk->fd );
+        disk->fd = -1;
+
+        return -1;
+    }
+
+    disk->data = ( char * ) map;
+
+    return existed;
+}
+
+
+
+/**
+ * Method: Opens the image file for block-at-a-time positioned I/O;
+ *  nothing is read until a block is asked for
+ *
+ * @param: disk_t * disk - the disk
+ * @param: char * name - the image file to open
+ *
+ * Return: int - 1 if the image already held data, 0 if it is new
+ *      and -1 on error
+ */
+int disk_mount_pio( disk_t * disk, char * name )
+{
+    int existed;
+
+    if( disk->backend == DISK_DIRECT && posix_memalign(( void ** ) &disk->directBuf, DIRECT_ALIGN, MIN_BLOCK_SIZE ) != 0 )
+    {
+        fprintf( stderr, "disk_mount: out of memory\n" );
+
+        return -1;
+    }
+
+    existed = disk_open( disk, name, ( disk->backend == DISK_DIRECT ) ? O_DIRECT : 0 );
+
+    if( existed < 0 )
+    {
+        free( disk->directBuf );
+        disk->directBuf = NULL;
+    }
+
+    return existed;
+}
+
+
+
+/**
+ * Method: Reads the whole image file into memory
+ *
+ * @param: disk_t * disk - the disk
+ * @param: char * name - the image file to load
+ *
+ * Return: int - 1 if the image already held data, 0 if it is new
+ *      and -1 on error
+ */
+int disk_mount_memory( disk_t * disk, char * name )
+{
+        //---VARIABLE(S)---
+        int existed = disk_open( disk, name, 0 );
+        size_t done = 0;
+        ssize_t got;
+
+        if( existed <= 0 )
+        {
+                return existed;
+        }
+
+        disk->data = malloc( disk->bytes );
+
+        if( disk->data == NULL )
+        {
+                fprintf( stderr, "disk_mount: out of memory\n" );
+                close( disk->fd );
+                disk->fd = -1;
+                disk->bytes = 0;
+
+                return -1;
+        }
+
+        while( done < disk->bytes && ( got = pread( disk->fd, disk->data + done, disk->bytes - done, ( off_t ) done )) > 0 )
+        {
+                done += got;
+        }
+
+        return existed;
+}
+
+
+
+int disk_mount( disk_t * disk, char * name )
+{
+        int existed;
+
+        disk->blockSize = MIN_BLOCK_SIZE;
+        disk->bytes = 0;
+
+        if( disk->backend == DISK_MMAP )
+        {
+                existed = disk_mount_mmap( disk, name );
+        }
+        else if( disk->backend == DISK_PIO || disk->backend == DISK_DIRECT )
+        {
+                existed = disk_mount_pio( disk, name );
+        }
+        else
+        {
+                existed = disk_mount_memory( disk, name );
+        }
+
+        disk->blockCount = disk->bytes / MIN_BLOCK_SIZE;
+
+        return existed;
+}
+
+
+
+int disk_umount( disk_t * disk )
+{
+        disk_sync( disk );
+
+        if( disk->backend == DISK_MMAP )
+        {
+                munmap( disk->data, disk->bytes );
+        }
+        else if( disk->backend == DISK_MEMORY )
+        {
+                free( disk->data );
+        }
+
+        close( disk->fd );
+        free( disk->directBuf );
+        free( disk->dirty );
+
+        disk->fd = -1;
+        disk->data = NULL;
+        disk->directBuf = NULL;
+        disk->dirty = NULL;
+        disk->dirtyBytes = 0;
+        disk->blockCount = 0;
 
-		fwrite( disk, BLOCK_SIZE, MAX_BLOCK, fp );
-		fclose( fp );
-		
         return 1;
-}
\ No newline at end of file
+}
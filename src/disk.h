@@ -8,15 +8,46 @@
  *      directory and inode structures.
  *********************************************************/
 
+#ifndef DISK_H
+#define DISK_H
+
+//---IMPORT(S)---
+#include <sys/uio.h>
+
 //---DEFINITION(S)---
-#define BLOCK_SIZE 512
-#define MAX_BLOCK 4096
+#define MIN_BLOCK_SIZE 512
+#define MAX_BLOCK_SIZE 65536
 
-//---GLOBAL VARIABLE(S)
-extern char disk[MAX_BLOCK][BLOCK_SIZE];
+//How the disk image is kept while it is mounted
+typedef enum {DISK_MEMORY, DISK_MMAP, DISK_PIO, DISK_DIRECT} BACKEND;
+
+//One mounted image. data is the image itself for DISK_MEMORY and
+//  DISK_MMAP; dirty has a bit per block written since the last sync
+typedef struct
+{
+        char * data;
+        BACKEND backend;
+        int fd;
+        int blockSize;
+        int blockCount;
+        size_t bytes;
+        size_t dirtyBytes;
+        char * directBuf;
+        unsigned char * dirty;
+} disk_t;
 
 //---METHOD INSTANTIATION(S)---
-int disk_read( int block, char * buf );
-int disk_write( int block, char * buf );
-int disk_mount( char * name );
-int disk_umount( char * name );
\ No newline at end of file
+void disk_setup( disk_t * disk );
+int disk_read( disk_t * disk, int block, char * buf );
+int disk_write( disk_t * disk, int block, char * buf );
+int disk_readv( disk_t * disk, int block, char ** bufs, int count );
+int disk_writev( disk_t * disk, int block, char ** bufs, int count );
+int disk_sync( disk_t * disk );
+int disk_write_out( int fd, struct iovec * iov, int count );
+int disk_send( disk_t * disk, int fd, int block, long long bytes );
+int disk_mount( disk_t * disk, char * name );
+int disk_umount( disk_t * disk );
+int disk_set_backend( disk_t * disk, BACKEND backend );
+int disk_set_geometry( disk_t * disk, int blockSize, int blockCount );
+
+#endif
@@ -12,23 +12,314 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "fs.h"
 #include "fs_util.h"
 #include "disk.h"
+#include "cache.h"
+#include "bmap.h"
+#include "dir.h"
+#include "dcache.h"
 
 //---GLOBAL VARIABLE(S)---
-//STRUCT(S)
-Inode inode[MAX_INODE];
-SuperBlock superBlock;
-Dentry curDir;
-//BOOLEAN(S)
-int hasRemovedBefore = 0;
-//INT(S)
-int curDirBlock;
-int currentDirectoryInode;
-//CHAR(S)
-char inodeMap[MAX_INODE / 8];
-char blockMap[MAX_BLOCK / 8];
+//COMMAND(S)
+Command commandTable[NUM_COMMAND] = {
+    { "create", 2, "create <filename> <size>" },
+    { "cat", 1, "cat <filename>" },
+    { "write", 4, "write <filename> <offset> <size> <buf>" },
+    { "read", 3, "read <filename> <offset> <size>" },
+    { "rm", 1, "rm <filename>" },
+    { "mkdir", 1, "mkdir <dirname>" },
+    { "rmdir", 1, "rmdir <dirname>" },
+    { "cd", 1, "cd <dirname>" },
+    { "ls", 0, "ls [<path>]" },
+    { "stat", 1, "stat <filename>" },
+    { "df", 0, "df" },
+    { "sync", 0, "sync" },
+    { "open", 1, "open <filename>" },
+    { "close", 1, "close <fd>" },
+    { "seek", 2, "seek <fd> <offset>" },
+    { "pread", 3, "pread <fd> <offset|-1> <size>" },
+    { "pwrite", 4, "pwrite <fd> <offset|-1> <size> <buf>" },
+    { "writein", 3, "writein <filename> <offset> <size>, then size bytes" },
+    { "writefrom", 3, "writefrom <filename> <offset> <host_file>" }
+};
+//  commandTable index + 1 by name hash, 0 for an empty slot
+int commandSlot[COMMAND_SLOT];
+//PTHREAD_ONCE(S)
+pthread_once_t commandOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Method: Allocates a handle for one volume, with the default backend,
+ *  cache size and format geometry; it is mounted with fs_mount
+ *
+ * @param: None
+ *
+ * Return: fs_t * - the handle or NULL if out of memory
+ */
+fs_t * fs_new()
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    //  fs_t *(s)
+    fs_t * fs;
+    
+    //  The directory views are loaded with aligned vector loads
+    if( posix_memalign(( void ** ) &fs, __alignof__( fs_t ), sizeof( fs_t )) != 0 )
+    {
+        fprintf( stderr, "fs_new: out of memory\n" );
+        
+        return NULL;
+    }
+    
+    memset( fs, 0, sizeof( fs_t ));
+    pthread_rwlock_init( &fs->volumeLock, NULL );
+    pthread_mutex_init( &fs->allocLock, NULL );
+    pthread_mutex_init( &fs->xlatLock, NULL );
+    
+    for( i = 0; i < DIR_VIEW; i++ )
+    {
+        pthread_rwlock_init( &fs->dirView[i].lock, NULL );
+    }
+    
+    pthread_rwlock_init( &fs->dcacheLock, NULL );
+    pthread_mutex_init( &fs->openLock, NULL );
+    disk_setup( &fs->disk );
+    cache_setup( &fs->cache, &fs->disk );
+    fs->formatBlockSize = DEFAULT_BLOCK_SIZE;
+    fs->formatBlockCount = DEFAULT_MAX_BLOCK;
+    fs->formatInodeCount = DEFAULT_MAX_INODE;
+    
+    return fs;
+}
+
+
+
+/**
+ * Method: Frees a handle made by fs_new; the volume has to be
+ *  unmounted first
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Return: None
+ */
+void fs_free( fs_t * fs )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    
+    pthread_rwlock_destroy( &fs->volumeLock );
+    pthread_mutex_destroy( &fs->allocLock );
+    pthread_mutex_destroy( &fs->xlatLock );
+    
+    for( i = 0; i < DIR_VIEW; i++ )
+    {
+        pthread_rwlock_destroy( &fs->dirView[i].lock );
+    }
+    
+    pthread_rwlock_destroy( &fs->dcacheLock );
+    pthread_mutex_destroy( &fs->openLock );
+    pthread_mutex_destroy( &fs->cache.lock );
+    pthread_cond_destroy( &fs->cache.done );
+    free( fs );
+}
+
+
+
+/**
+ * Method: Sets the geometry used when fs_mount has to format a new
+ *  disk; an existing disk always keeps the geometry in its SuperBlock
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int blockSize - bytes per block, a power of two from
+ *      MIN_BLOCK_SIZE to MAX_BLOCK_SIZE
+ * @param: int blockCount - number of blocks on the disk
+ * @param: int inodeCount - number of inodes on the disk
+ *
+ * Return: int
+ */
+int fs_set_geometry( fs_t * fs, int blockSize, int blockCount, int inodeCount )
+{
+    //---VARIABLE(S)---
+    //  long long(s)
+    long long metaBlocks;
+    
+    //  ERROR CHECK: block size must be a power of two within range
+    if( blockSize < MIN_BLOCK_SIZE || blockSize > MAX_BLOCK_SIZE || ( blockSize & ( blockSize - 1 )) != 0 )
+    {
+        printf( "Format error: block size must be a power of two from %d to %d\n", MIN_BLOCK_SIZE, MAX_BLOCK_SIZE );
+        
+        return -1;
+    }
+    
+    //  ERROR CHECK: there must be at least one inode
+    if( inodeCount < 1 )
+    {
+        printf( "Format error: need at least 1 inode\n" );
+        
+        return -1;
+    }
+    
+    //  ERROR CHECK: the metadata plus the root directory have to fit
+    metaBlocks = 1 + ( inodeCount / 8 + blockSize - 1 ) / blockSize
+                   + ( blockCount / 8 + blockSize - 1 ) / blockSize
+                   + (( long long ) inodeCount * sizeof( Inode ) + blockSize - 1 ) / blockSize;
+    
+    if( blockCount < 1 || metaBlocks + 1 > blockCount )
+    {
+        printf( "Format error: %d blocks is too small for %d inodes\n", blockCount, inodeCount );
+        
+        return -1;
+    }
+    
+    fs->formatBlockSize = blockSize;
+    fs->formatBlockCount = blockCount;
+    fs->formatInodeCount = inodeCount;
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Fills in where the bitmaps, inode table and data blocks
+ *  start from the geometry already in superBlock
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Return: None
+ */
+void fs_layout( fs_t * fs )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int bs = fs->superBlock.blockSize;
+    
+    fs->superBlock.inodeMapStart = 1;
+    fs->superBlock.blockMapStart = fs->superBlock.inodeMapStart + ( fs->superBlock.inodeCount / 8 + bs - 1 ) / bs;
+    fs->superBlock.inodeTableStart = fs->superBlock.blockMapStart + ( fs->superBlock.blockCount / 8 + bs - 1 ) / bs;
+    fs->superBlock.dataStart = fs->superBlock.inodeTableStart
+                         + ( int )((( long long ) fs->superBlock.inodeCount * sizeof( Inode ) + bs - 1 ) / bs );
+}
+
+
+
+/**
+ * Method: Frees what fs_alloc_tables allocated; the per-inode locks
+ *  only exist once every table did
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Return: None
+ */
+void fs_free_tables( fs_t * fs )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    
+    for( i = 0; fs->inodeLock != NULL && i < fs->superBlock.inodeCount; i++ )
+    {
+        pthread_rwlock_destroy( &fs->inodeLock[i] );
+        pthread_mutex_destroy( &fs->readahead[i].lock );
+    }
+    
+    free( fs->inodeMap );
+    free( fs->blockMap );
+    free( fs->inode );
+    free( fs->metaDirty );
+    free( fs->readahead );
+    free( fs->inodeLock );
+    fs->inodeMap = NULL;
+    fs->blockMap = NULL;
+    fs->inode = NULL;
+    fs->metaDirty = NULL;
+    fs->readahead = NULL;
+    fs->inodeLock = NULL;
+}
+
+
+
+/**
+ * Method: Allocates the in-memory bitmaps and inode table, each
+ *  rounded up to whole blocks so they can be read and written with
+ *  disk_read / disk_write, and the per-inode locks
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Return: int
+ */
+int fs_alloc_tables( fs_t * fs )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    //  size_t(s)
+    size_t bs = fs->superBlock.blockSize;
+    
+    fs->inodeMap = calloc( fs->superBlock.blockMapStart - fs->superBlock.inodeMapStart, bs );
+    fs->blockMap = calloc( fs->superBlock.inodeTableStart - fs->superBlock.blockMapStart, bs );
+    fs->inode = calloc( fs->superBlock.dataStart - fs->superBlock.inodeTableStart, bs );
+    fs->metaDirty = calloc( fs->superBlock.dataStart / 8 + 1, 1 );
+    fs->readahead = calloc( fs->superBlock.inodeCount, sizeof( Readahead ));
+    fs->inodeLock = malloc( fs->superBlock.inodeCount * sizeof( pthread_rwlock_t ));
+    
+    if( fs->inodeMap == NULL || fs->blockMap == NULL || fs->inode == NULL || fs->metaDirty == NULL || fs->readahead == NULL
+        || fs->inodeLock == NULL )
+    {
+        fprintf( stderr, "fs_mount: out of memory\n" );
+        free( fs->inodeLock );
+        fs->inodeLock = NULL;
+        fs_free_tables( fs );
+        
+        return -1;
+    }
+    
+    for( i = 0; i < fs->superBlock.inodeCount; i++ )
+    {
+        pthread_rwlock_init( &fs->inodeLock[i], NULL );
+        pthread_mutex_init( &fs->readahead[i].lock, NULL );
+    }
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Reads or writes the contiguous blocks that hold a table;
+ *  only blocks marked dirty are written
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int start - first block of the table
+ * @param: int end - block after the last block of the table
+ * @param: char * table - the in-memory copy
+ * @param: int write - 1 to write the table, 0 to read it
+ *
+ * Return: None
+ */
+void fs_table_io( fs_t * fs, int start, int end, char * table, int write )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    
+    for( i = start; i < end; i++ )
+    {
+        if( write && get_bit( fs->metaDirty, i ))
+        {
+            cache_write( &fs->cache, i, table + ( size_t )( i - start ) * fs->superBlock.blockSize );
+            set_bit( fs->metaDirty, i, 0 );
+        }
+        else if( !write )
+        {
+            cache_read( &fs->cache, i, table + ( size_t )( i - start ) * fs->superBlock.blockSize );
+        }
+    }
+}
 
 
 
@@ -37,316 +328,1892 @@ char blockMap[MAX_BLOCK / 8];
  *  already saved or it will create a disk structure; Provided
  *  by the professor
  *
+ * @param: fs_t * fs - the volume
  * @param: char * name - name of the disk to mount
  *
  * Return: int
  */
-int fs_mount( char * name )
+int fs_mount( fs_t * fs, char * name )
 {
     //---VARIALBE(S)---
     //  int(S)
     int i = 0;
-    int index = 0;
-    int inode_index = 0;
-    int numInodeBlock =  ( sizeof( Inode ) * MAX_INODE ) / BLOCK_SIZE;
+    int mounted = disk_mount( &fs->disk, name );
+    
+    if( mounted < 0 )
+    {
+        fprintf( stderr, "fs_mount: could not mount %s\n", name );
+        
+        return -1;
+    }
     
     // load superblock, inodeMap, blockMap and inodes into the memory
-    if( disk_mount( name ) == 1 )
+    if( mounted == 1 )
     {
-        disk_read( 0, ( char* ) &superBlock );
-        disk_read( 1, inodeMap  );
-        disk_read( 2, blockMap);
+        read_struct( fs, 0, &fs->superBlock, sizeof( SuperBlock ));
         
-        for( i = 0; i < numInodeBlock; i++ )
+        //  Images written before the geometry was stored
+        if( fs->superBlock.magic != FS_MAGIC )
         {
-            index = i + 3;
-            disk_read( index, ( char* ) ( inode + inode_index ));
-            inode_index += ( BLOCK_SIZE / sizeof( Inode ));
+            fs->superBlock.magic = FS_MAGIC;
+            fs->superBlock.blockSize = DEFAULT_BLOCK_SIZE;
+            fs->superBlock.blockCount = DEFAULT_MAX_BLOCK;
+            fs->superBlock.inodeCount = DEFAULT_MAX_INODE;
+            fs_layout( fs );
         }
         
-        // root directory
-        curDirBlock = inode[0].directBlock[0];
+        if( disk_set_geometry( &fs->disk, fs->superBlock.blockSize, fs->superBlock.blockCount ) < 0
+            || cache_init( &fs->cache, fs->superBlock.blockSize ) < 0 || fs_alloc_tables( fs ) < 0 )
+        {
+            goto fail;
+        }
+        
+        fs_table_io( fs, fs->superBlock.inodeMapStart, fs->superBlock.blockMapStart, fs->inodeMap, 0 );
+        fs_table_io( fs, fs->superBlock.blockMapStart, fs->superBlock.inodeTableStart, fs->blockMap, 0 );
+        fs_table_io( fs, fs->superBlock.inodeTableStart, fs->superBlock.dataStart, ( char* ) fs->inode, 0 );
+        
+        if( bitmap_summary_build( fs ) < 0 || extent_index_build( fs ) < 0 )
+        {
+            goto fail;
+        }
         
-        disk_read( curDirBlock, ( char* )&curDir );
+        // root directory
+        fs->currentDirectoryInode = 0;
     }
     else
     {
         // Init file system superblock, inodeMap and blockMap
-        superBlock.freeBlockCount = MAX_BLOCK - ( 1 + 1 + 1 + numInodeBlock );
-        superBlock.freeInodeCount = MAX_INODE;
+        fs->superBlock.magic = FS_MAGIC;
+        fs->superBlock.blockSize = fs->formatBlockSize;
+        fs->superBlock.blockCount = fs->formatBlockCount;
+        fs->superBlock.inodeCount = fs->formatInodeCount;
+        fs_layout( fs );
+        
+        if( disk_set_geometry( &fs->disk, fs->superBlock.blockSize, fs->superBlock.blockCount ) < 0
+            || cache_init( &fs->cache, fs->superBlock.blockSize ) < 0 || fs_alloc_tables( fs ) < 0 )
+        {
+            goto fail;
+        }
         
-        //Init inodeMap
-        for( i = 0; i < MAX_INODE / 8; i++ )
+        fs->superBlock.freeBlockCount = fs->superBlock.blockCount - fs->superBlock.dataStart;
+        fs->superBlock.freeInodeCount = fs->superBlock.inodeCount;
+        
+        //Init blockMap; the superblock, bitmaps and inode table are in use
+        //  and all of them still have to be written
+        for( i = 0; i < fs->superBlock.dataStart; i++ )
         {
-            set_bit( inodeMap, i, 0);
+            set_bit( fs->blockMap, i, 1 );
+            mark_dirty( fs, i );
         }
         
-        //Init blockMap
-        for( i = 0; i < MAX_BLOCK / 8; i++ )
+        if( bitmap_summary_build( fs ) < 0 || extent_index_build( fs ) < 0 )
         {
-            if( i < ( 1 + 1 + 1 + numInodeBlock ))
-            {
-                set_bit( blockMap, i, 1 );
-            }
-            else
-            {
-                set_bit( blockMap, i, 0 );
-            }
+            goto fail;
         }
         
         //Init root dir
-        int rootInode = get_free_inode();
-        currentDirectoryInode = rootInode;
-        
-        curDirBlock = get_free_block();
+        int rootInode = get_free_inode( fs );
+        fs->currentDirectoryInode = rootInode;
         
-        inode[rootInode].type = directory;
-        inode[rootInode].owner = 0;
-        inode[rootInode].group = 0;
+        fs->inode[rootInode].type = directory;
+        fs->inode[rootInode].owner = 0;
+        fs->inode[rootInode].group = 0;
+        bmap_init( fs, rootInode, 0 );
         
-        gettimeofday( &( inode[rootInode].created ), NULL );
-        gettimeofday( &( inode[rootInode].lastAccess ), NULL );
+        gettimeofday( &( fs->inode[rootInode].created ), NULL );
+        gettimeofday( &( fs->inode[rootInode].lastAccess ), NULL );
         
-        inode[rootInode].size = 1;
-        inode[rootInode].blockCount = 1;
-        inode[rootInode].directBlock[0] = curDirBlock;
+        fs->inode[rootInode].size = 1;
+        dirty_inode( fs, rootInode );
         
-        curDir.numEntry = 1;
-        strncpy( curDir.dentry[0].name, ".", 1 );
-        curDir.dentry[0].name[1] = '\0';
-        curDir.dentry[0].inode = rootInode;
-        currentDirectoryInode = rootInode;
-        
-        disk_write( curDirBlock, ( char* ) &curDir );
+        //  The root has no ".." entry
+        if( dir_init( fs, rootInode, -1 ) < 0 )
+        {
+            goto fail;
+        }
     }
     
     return 0;
+    
+    //  Undo a mount that failed part way; each step copes with what
+    //  was never set up
+fail:
+    cache_destroy( &fs->cache );
+    disk_umount( &fs->disk );
+    fs_free_tables( fs );
+    extent_index_free( fs );
+    bitmap_summary_free( fs );
+    bmap_destroy( fs );
+    dir_view_reset( fs );
+    dcache_reset( fs );
+    
+    return -1;
 }
 
 
 
 /**
- * Method: will unmount the "disk"; Provided by the professor
+ * Method: Writes the metadata blocks that changed since the last
+ *  sync, flushes the buffer cache, directories included, and pushes
+ *  the dirty blocks out to the image file. The caller holds
+ *  volumeLock exclusively
  *
- * @param: char * name - the name of the disk to unmount
+ * @param: fs_t * fs - the volume
  *
  * Return: int
  */
-int fs_umount( char * name )
+int fs_flush( fs_t * fs )
 {
-    int numInodeBlock =  ( sizeof( Inode ) * MAX_INODE ) / BLOCK_SIZE;
-    int i, index, inode_index = 0;
+    if( get_bit( fs->metaDirty, 0 ))
+    {
+        write_struct( fs, 0, &fs->superBlock, sizeof( SuperBlock ));
+        set_bit( fs->metaDirty, 0, 0 );
+    }
     
-    disk_write( 0, ( char* ) &superBlock );
-    disk_write( 1, inodeMap );
-    disk_write( 2, blockMap );
+    fs_table_io( fs, fs->superBlock.inodeMapStart, fs->superBlock.blockMapStart, fs->inodeMap, 1 );
+    fs_table_io( fs, fs->superBlock.blockMapStart, fs->superBlock.inodeTableStart, fs->blockMap, 1 );
+    fs_table_io( fs, fs->superBlock.inodeTableStart, fs->superBlock.dataStart, ( char* ) fs->inode, 1 );
     
-    for( i = 0; i < numInodeBlock; i++ )
+    if( cache_flush( &fs->cache ) < 0 )
     {
-        index = i + 3;
-        disk_write( index, ( char* ) ( inode + inode_index ));
-        inode_index += ( BLOCK_SIZE / sizeof( Inode ));
+        return -1;
     }
-    // current directory
-    disk_write( curDirBlock, ( char* ) &curDir );
     
-    disk_umount( name );
-    
-    return 0;
+    return disk_sync( &fs->disk );
 }
 
 
 
 /**
- * Method: Will search the directory for a file name
- *  passed in; It will return -1 if file doesn't exist; Provided
- *  by the professor
+ * Method: Syncs the volume once every running command is done
  *
- * @param: char * name - the name of the file that will be searched
+ * @param: fs_t * fs - the volume
  *
  * Return: int
  */
-int search_cur_dir( char * name )
+int fs_sync( fs_t * fs )
 {
     //---VARIABLE(S)---
     //  int(s)
-    int i;
+    int result;
     
-    for( i = 0; i < MAX_DIR_ENTRY; i++ )
-    {
-        if( command( name, curDir.dentry[i].name ))
-        {
-            return curDir.dentry[i].inode;
-        }
-    }
+    pthread_rwlock_wrlock( &fs->volumeLock );
+    result = fs_flush( fs );
+    pthread_rwlock_unlock( &fs->volumeLock );
     
-    return -1; // return inode. If not exist, return -1
+    return result;
 }
 
 
 
 /**
- * Method: Creates a file by taking in name and size from
- *      user input; Implemented by Alan Guilfoyle
+ * Method: will unmount the "disk"; Provided by the professor
  *
- * @param: char * name - file name that will be created
- * @param: int size - the size of the file to create
+ * @param: fs_t * fs - the volume
  *
- * RETURN: int
+ * Return: int
  */
-int file_create( char * name, int size )
+int fs_umount( fs_t * fs )
 {
-    //---VARIABLE(S)---
-    //  boolean(s)
-    int foundSpot = 0;
-    //  integer(s)
-    int i;
-    int inodeNum;
-    int numBlock;
+    pthread_rwlock_wrlock( &fs->volumeLock );
+    fs_flush( fs );
     
-    if( size >= SMALL_FILE )
-    {
-        printf( "File create error: Do not support files larger than %d bytes yet.\n", SMALL_FILE );
-        
-        return -1;
-    }
+    cache_destroy( &fs->cache );
+    disk_umount( &fs->disk );
     
-    inodeNum = search_cur_dir( name );
+    fs_free_tables( fs );
+    extent_index_free( fs );
+    bitmap_summary_free( fs );
+    bmap_destroy( fs );
+    dir_view_reset( fs );
+    dcache_reset( fs );
+    memset( fs->openFile, 0, sizeof( fs->openFile ));
+    pthread_rwlock_unlock( &fs->volumeLock );
     
-    if( inodeNum >= 0 )
+    return 0;
+}
+
+
+
+/**
+ * Method: Takes an inode's lock, shared for readers and exclusive for
+ *  a writer
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the inode
+ * @param: int write - 1 for the exclusive lock
+ *
+ * Return: None
+ */
+void inode_lock( fs_t * fs, int inodeNum, int write )
+{
+    if( write )
     {
-        printf( "File create error:  %s exist.\n", name );
-        
-        return -1;
+        pthread_rwlock_wrlock( &fs->inodeLock[inodeNum] );
     }
-    printf( "%lu\n", BLOCK_SIZE / sizeof( DirectoryEntry ) );
-    
-    if( curDir.numEntry + 1 > ( BLOCK_SIZE / sizeof( DirectoryEntry )))
+    else
     {
-        printf( "File create error: directory is full!\n" );
-        
-        return -1;
+        pthread_rwlock_rdlock( &fs->inodeLock[inodeNum] );
     }
+}
+
+
+
+/**
+ * Method: Lets go of an inode's lock
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the inode
+ *
+ * Return: None
+ */
+void inode_unlock( fs_t * fs, int inodeNum )
+{
+    pthread_rwlock_unlock( &fs->inodeLock[inodeNum] );
+}
+
+
+
+/**
+ * Method: Updates an inode's access time; readers only share the
+ *  inode lock, so the time is set under its readahead lock
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the inode
+ *
+ * Return: None
+ */
+void inode_touch( fs_t * fs, int inodeNum )
+{
+    pthread_mutex_lock( &fs->readahead[inodeNum].lock );
+    gettimeofday( &( fs->inode[inodeNum].lastAccess ), NULL );
+    pthread_mutex_unlock( &fs->readahead[inodeNum].lock );
+    dirty_inode( fs, inodeNum );
+}
+
+
+
+/**
+ * Method: Finds the directory a path's last component lives in.
+ *  Paths starting with '/' begin at the root, others at the current
+ *  directory; empty components are skipped and ".." at the root stays
+ *  there. Every step goes through the dentry cache, so a path used
+ *  before is resolved without reading a block. Each directory on the
+ *  way is read under its shared lock, which is let go before the next
+ *  one is taken; directories are only removed under the exclusive
+ *  volumeLock, so the caller holds volumeLock shared
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char * path - the path
+ * @param: int * dirInode - set to the inode of the last component's
+ *      directory
+ * @param: char * name - set to the last component, "." for "/"
+ *
+ * Return: int - 0, or -1 if a directory on the way does not exist or
+ *  a component is too long for a directory entry
+ */
+int path_parent( fs_t * fs, char * path, int * dirInode, char * name )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int next;
+    int dir = ( path[0] == '/' ) ? 0 : fs->currentDirectoryInode;
+    //  size_t(s)
+    size_t len;
+    //  char *(s)
+    char * end;
     
-    //  Sets initalizied number of blocks
-    numBlock = size / BLOCK_SIZE;
+    strcpy( name, "." );
     
-    //  Adds to the size depending on the file size
-    if( size % BLOCK_SIZE > 0 )
+    while( *path != '\0' )
     {
-        numBlock++;
-    }
+        //  Skip the separators, a trailing one leaves name as it was
+        while( *path == '/' )
+        {
+            path++;
+        }
+        
+        if( *path == '\0' )
+        {
+            break;
+        }
+        
+        //  The component before this one has to be a directory
+        if( strcmp( name, "." ) != 0 )
+        {
+            inode_lock( fs, dir, 0 );
+            next = dir_lookup( fs, dir, name );
+            inode_unlock( fs, dir );
+            
+            if(( dir = next ) < 0 || fs->inode[dir].type != directory )
+            {
+                return -1;
+            }
+        }
+        
+        end = strchr( path, '/' );
+        len = ( end == NULL ) ? strlen( path ) : ( size_t )( end - path );
+        
+        //ERROR CHECKING: A component that would not fit is not cut short
+        if( len > MAX_FILE_NAME - 1 )
+        {
+            printf( "Path error: %.*s is longer than %d characters\n", ( int ) len, path, MAX_FILE_NAME - 1 );
+            name[0] = '\0';
+            
+            return -1;
+        }
+        
+        memset( name, 0, MAX_FILE_NAME );
+        memcpy( name, path, len );
+        path += len;
+        
+        //  The root has no ".." entry, it is its own parent
+        if( dir == 0 && strcmp( name, ".." ) == 0 )
+        {
+            strcpy( name, "." );
+        }
+    }
+    
+    *dirInode = dir;
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Will resolve a path to its inode and lock it; It will
+ *  return -1 if the file doesn't exist. A file is locked before its
+ *  directory is let go so it cannot be removed in between, a
+ *  directory after, so no two directories are ever held at once. The
+ *  caller holds volumeLock shared and unlocks the inode when done
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char * path - the path of the file that will be searched
+ * @param: int write - 1 to lock the inode exclusively
+ *
+ * Return: int
+ */
+int path_lookup( fs_t * fs, char * path, int write )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int dirInode;
+    int inodeNum;
+    int isFile;
+    //  char(s)
+    char name[MAX_FILE_NAME];
+    
+    if( path_parent( fs, path, &dirInode, name ) < 0 )
+    {
+        return -1;
+    }
+    
+    inode_lock( fs, dirInode, 0 );
+    inodeNum = dir_lookup( fs, dirInode, name ); // return inode. If not exist, return -1
+    isFile = ( inodeNum >= 0 && fs->inode[inodeNum].type == file );
+    
+    if( isFile )
+    {
+        inode_lock( fs, inodeNum, write );
+    }
+    
+    inode_unlock( fs, dirInode );
+    
+    if( inodeNum >= 0 && !isFile )
+    {
+        inode_lock( fs, inodeNum, write );
+    }
+    
+    return inodeNum;
+}
+
+
+
+/**
+ * Method: Gives a file new data blocks [first, last) and writes data
+ *  into them; blocks are taken as contiguous extents, each one
+ *  continuing from the block before it when that is free, so the
+ *  file's blocks reach the disk in one write per run
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int first - the first block index to allocate
+ * @param: int last - one past the last block index to allocate
+ * @param: char * data - the whole file contents, block aligned, or
+ *      NULL when the caller fills the blocks itself
+ *
+ * Return: int
+ */
+int file_alloc_blocks( fs_t * fs, int inodeNum, int first, int last, char * data )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int k;
+    int got;
+    int block = ( first > 0 ) ? bmap_get( fs, inodeNum, first - 1 ) : 0;
+    int goal = ( block > 0 ) ? block + 1 : -1;
+    
+    for( i = first; i < last; i += got )
+    {
+        block = alloc_extent( fs, goal, last - i, &got );
+    
+        if( block == -1 )
+        {
+            bmap_unmap( fs, inodeNum, first, i );
+            
+            return -1;
+        }
+        
+        //  A run that does not continue the last extent needs a record
+        if(( fs->inode[inodeNum].flags & INODE_EXTENTS ) && block != goal && fs->inode[inodeNum].extentCount >= extent_max_records( fs ))
+        {
+            fprintf( stderr, "extent map: inode %d is limited to %d extents\n", inodeNum, extent_max_records( fs ));
+            bmap_unmap( fs, inodeNum, first, i );
+            
+            for( k = 0; k < got; k++ )
+            {
+                put_free_block( fs, block + k );
+            }
+            
+            return -1;
+        }
+    
+        for( k = 0; k < got; k++ )
+        {
+            if( bmap_set( fs, inodeNum, i + k, block + k ) < 0 )
+            {
+                //  Gives back what this call took, the unmapped rest
+                //  of the run included
+                bmap_unmap( fs, inodeNum, first, i + k );
+                
+                for( ; k < got; k++ )
+                {
+                    put_free_block( fs, block + k );
+                }
+                
+                return -1;
+            }
+            
+            if( data != NULL )
+            {
+                cache_write( &fs->cache, block + k, data + (( size_t )( i + k ) * fs->superBlock.blockSize ));
+            }
+        }
+    
+        goal = block + got;
+    }
+    
+    dirty_inode( fs, inodeNum );
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Writes size bytes of buf into a file at offset, which may be
+ *  at most the file size. Only the first and last blocks are read
+ *  back when they are partly overwritten; whole blocks are written
+ *  straight into the cache and blocks are only allocated past the end
+ *  of the file. Inline files move to data blocks once they outgrow
+ *  the inode
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int offset - the first byte to write
+ * @param: int size - the number of bytes to write
+ * @param: char * buf - the bytes, which may include NULs
+ *
+ * Return: int - the number of bytes written or -1 on error
+ */
+int file_write_range( fs_t * fs, int inodeNum, int offset, int size, char * buf )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int bs = fs->superBlock.blockSize;
+    int blockNum = fs->inode[inodeNum].blockCount;
+    int newBlockNum;
+    int done = 0;
+    int promote = 0;
+    int first;
+    int got;
+    int grow;
+    int reserved;
+    int result = 0;
+    //  long long(s)
+    long long end = ( long long ) offset + size;
+    long long newSize = ( end > fs->inode[inodeNum].size ) ? end : fs->inode[inodeNum].size;
+    //  char *(s)
+    char * data;
+    char * scratch = NULL;
+    char old[INLINE_DATA];
+    
+    if( offset < 0 || size < 0 || offset > fs->inode[inodeNum].size )
+    {
+        return -1;
+    }
+    
+    if(( newSize + bs - 1 ) / bs > bmap_max_blocks( fs, fs->inode[inodeNum].flags ) || newSize > 0x7FFFFFFF )
+    {
+        printf( "File write error: files are limited to %lld blocks\n", bmap_max_blocks( fs, fs->inode[inodeNum].flags ));
+        
+        return -1;
+    }
+    
+    if( fs->inode[inodeNum].flags & INODE_INLINE )
+    {
+        if( newSize <= INLINE_DATA )
+        {
+            memcpy( fs->inode[inodeNum].inlineData + offset, buf, size );
+            fs->inode[inodeNum].size = newSize;
+            dirty_inode( fs, inodeNum );
+            
+            return size;
+        }
+        
+        //  Outgrew the inode: the bytes move to a first data block
+        promote = 1;
+        blockNum = 0;
+    }
+    
+    newBlockNum = ( newSize + bs - 1 ) / bs;
+    grow = newBlockNum > blockNum;
+    
+    if( grow )
+    {
+        //ERROR CHECKING: Ensures that there is enough space and holds
+        //  it until the blocks are mapped
+        reserved = newBlockNum - blockNum + bmap_grow_meta( fs, inodeNum, blockNum, newBlockNum );
+        
+        if( reserve_blocks( fs, reserved ) < 0 )
+        {
+            printf( "File write error: not enough space\n" );
+            
+            return -1;
+        }
+        
+        if( promote )
+        {
+            //  The block is taken and filled before the inline bytes are
+            //  given up, so a full disk leaves the file as it was
+            if(( scratch = calloc( bs, 1 )) == NULL || ( first = alloc_extent( fs, -1, 1, &got )) < 0 )
+            {
+                printf( "File write error: alloc_extent failed\n" );
+                unreserve_blocks( fs, reserved );
+                free( scratch );
+                
+                return -1;
+            }
+            
+            memcpy( old, fs->inode[inodeNum].inlineData, INLINE_DATA );
+            memcpy( scratch, old, fs->inode[inodeNum].size );
+            cache_write( &fs->cache, first, scratch );
+            bmap_init( fs, inodeNum, INODE_EXTENTS );
+            
+            if( bmap_set( fs, inodeNum, 0, first ) < 0 )
+            {
+                printf( "File write error: could not map block %d\n", first );
+                put_free_block( fs, first );
+                bmap_init( fs, inodeNum, INODE_INLINE );
+                memcpy( fs->inode[inodeNum].inlineData, old, INLINE_DATA );
+                unreserve_blocks( fs, reserved );
+                free( scratch );
+                
+                return -1;
+            }
+            
+            blockNum = 1;
+        }
+        
+        result = file_alloc_blocks( fs, inodeNum, blockNum, newBlockNum, NULL );
+        unreserve_blocks( fs, reserved );
+        
+        if( result < 0 )
+        {
+            printf( "File write error: alloc_extent failed\n" );
+        }
+    }
+    
+    while( result == 0 && done < size )
+    {
+        int pos = offset + done;
+        int index = pos / bs;
+        int block = bmap_get( fs, inodeNum, index );
+        int part = bs - pos % bs;
+        
+        if( part > size - done )
+        {
+            part = size - done;
+        }
+        
+        if( block == 0 ) //IF: Block 0 is the superblock, never file data
+        {
+            printf( "File write error: block %d of inode %d is not mapped\n", index, inodeNum );
+            result = -1;
+            
+            break;
+        }
+        else if( part == bs ) //ELSE IF: Whole block, nothing to read back
+        {
+            cache_write( &fs->cache, block, buf + done );
+        }
+        else if( index >= blockNum ) //ELSE IF: New block, the rest of it is zeros
+        {
+            if( scratch == NULL && ( scratch = malloc( bs )) == NULL )
+            {
+                result = -1;
+                
+                break;
+            }
+            
+            memset( scratch, 0, bs );
+            memcpy( scratch + pos % bs, buf + done, part );
+            cache_write( &fs->cache, block, scratch );
+        }
+        else //ELSE: Partly overwritten block, read-modify-write
+        {
+            data = cache_get( &fs->cache, block );
+            
+            if( data == NULL )
+            {
+                printf( "File write error: could not read block %d of inode %d\n", index, inodeNum );
+                result = -1;
+                
+                break;
+            }
+            
+            memcpy( data + pos % bs, buf + done, part );
+            cache_release( &fs->cache, block, 1 );
+        }
+        
+        done += part;
+    }
+    
+    free( scratch );
+    
+    if( result < 0 ) //IF: Give back what this call added, the size is unchanged
+    {
+        if( promote )
+        {
+            bmap_free( fs, inodeNum );
+            bmap_init( fs, inodeNum, INODE_INLINE );
+            memcpy( fs->inode[inodeNum].inlineData, old, INLINE_DATA );
+        }
+        else if( grow )
+        {
+            bmap_unmap( fs, inodeNum, blockNum, newBlockNum );
+        }
+        
+        return -1;
+    }
+    
+    if( grow )
+    {
+        fs->inode[inodeNum].blockCount = newBlockNum;
+    }
+    
+    fs->inode[inodeNum].size = newSize;
+    dirty_inode( fs, inodeNum );
+    
+    return size;
+}
+
+
+
+/**
+ * Method: Creates a file in a directory the caller holds locked
+ *  exclusively
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the directory
+ * @param: char * name - the file's name
+ * @param: int size - the size of the file to create
+ *
+ * Return: int
+ */
+int file_create_in( fs_t * fs, int dirInode, char * name, int size )
+{
+    //---VARIABLE(S)---
+    //  integer(s)
+    int inodeNum = dir_lookup( fs, dirInode, name );
+    int numBlock;
+    int reserved;
+    int result;
+    
+    if( inodeNum >= 0 )
+    {
+        printf( "File create error:  %s exist.\n", name );
+        
+        return -1;
+    }
+    
+    //  Sets initalizied number of blocks
+    numBlock = size / fs->superBlock.blockSize;
+    
+    //  Adds to the size depending on the file size
+    if( size % fs->superBlock.blockSize > 0 )
+    {
+        numBlock++;
+    }
+    
+    //  Tiny files live in the inode and need no data block at all
+    if( size <= INLINE_DATA )
+    {
+        numBlock = 0;
+    }
+    
+    //  Ensures that there are enough iNodes to add file
+    if( __atomic_load_n( &fs->superBlock.freeInodeCount, __ATOMIC_RELAXED ) < 1 )
+    {
+        printf( "File create error: not enough inodes\n" );
+        
+        return -1;
+    }
+    
+    //  Holds enough space for the file and its extent tree until they
+    //  are mapped
+    reserved = numBlock + extent_meta_blocks( fs, numBlock );
+    
+    if( reserve_blocks( fs, reserved ) < 0 )
+    {
+        printf( "File create error: not enough blocks\n");
+        
+        return -1;
+    }
+    
+    //  Sets random chars for a string based on size inputed
+    //  Whole blocks are written, so the buffer is padded out with zeros
+    char * tmp = ( char * ) calloc(( size_t ) numBlock * fs->superBlock.blockSize + INLINE_DATA + 1, 1 );
+    
+    if( tmp == NULL )
+    {
+        printf( "File create error: out of memory\n" );
+        unreserve_blocks( fs, reserved );
+        
+        return -1;
+    }
+    
+    rand_string( tmp, size);
+    printf( "Random String: %s\n", tmp );
+    
+    // Get inode and fill it
+    inodeNum = get_free_inode( fs );
+    
+    if( inodeNum < 0 )
+    {
+        printf( "File create error: not enough inode.\n" );
+        unreserve_blocks( fs, reserved );
+        free( tmp );
+        
+        return -1;
+    }
+    
+    //  Sets type, owner, group
+    fs->inode[inodeNum].type = file; //Is set to 0 for file
+    fs->inode[inodeNum].owner = 1;
+    fs->inode[inodeNum].group = 2;
+    
+    //  New files map their blocks with extents, tiny ones are inline
+    if( numBlock == 0 )
+    {
+        bmap_init( fs, inodeNum, INODE_INLINE );
+        memcpy( fs->inode[inodeNum].inlineData, tmp, size );
+    }
+    else
+    {
+        bmap_init( fs, inodeNum, INODE_EXTENTS );
+    }
+    
+    //  Sets time for create & access
+    gettimeofday( &( fs->inode[inodeNum].created ), NULL );
+    gettimeofday( &( fs->inode[inodeNum].lastAccess ), NULL );
+    
+    //  Sets the size; blockCount follows once the blocks are mapped
+    fs->inode[inodeNum].size = size;
+    dirty_inode( fs, inodeNum );
+    
+    // Add a new file into its directory
+    if( dir_add( fs, dirInode, name, inodeNum ) < 0 )
+    {
+        printf( "File create error: directory is full!\n" );
+        unreserve_blocks( fs, reserved );
+        put_free_inode( fs, inodeNum );
+        free( tmp );
+        
+        return -1;
+    }
+    
+    // Get data blocks
+    result = file_alloc_blocks( fs, inodeNum, 0, numBlock, tmp );
+    unreserve_blocks( fs, reserved );
+    
+    if( result < 0 )
+    {
+        //  Undo the create, the inode going back last
+        printf( "File create error: alloc_extent failed\n");
+        dir_delete( fs, dirInode, name );
+        bmap_free( fs, inodeNum );
+        put_free_inode( fs, inodeNum );
+        free( tmp );
+        
+        return -1;
+    }
+    
+    fs->inode[inodeNum].blockCount = numBlock;
+    
+    printf( "File created: %s, inode %d, size %d\n", name, inodeNum, size );
+    free( tmp );
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Creates a file by taking in name and size from
+ *      user input; its directory is locked exclusively throughout;
+ *      Implemented by Alan Guilfoyle
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char * path - path of the file that will be created
+ * @param: int size - the size of the file to create
+ *
+ * RETURN: int
+ */
+int file_create( fs_t * fs, char * path, int size )
+{
+    //---VARIABLE(S)---
+    //  integer(s)
+    int dirInode;
+    int result;
+    //  char(s)
+    char name[MAX_FILE_NAME];
+    
+    if( size < 0 || size / fs->superBlock.blockSize >= bmap_max_blocks( fs, INODE_EXTENTS ))
+    {
+        printf( "File create error: files are limited to %lld blocks\n", bmap_max_blocks( fs, INODE_EXTENTS ));
+        
+        return -1;
+    }
+    
+    pthread_rwlock_rdlock( &fs->volumeLock );
+    
+    if( path_parent( fs, path, &dirInode, name ) < 0 )
+    {
+        printf( "File create error: directory does not exist\n" );
+        pthread_rwlock_unlock( &fs->volumeLock );
+        
+        return -1;
+    }
+    
+    inode_lock( fs, dirInode, 1 );
+    result = file_create_in( fs, dirInode, name, size );
+    inode_unlock( fs, dirInode );
+    pthread_rwlock_unlock( &fs->volumeLock );
+    
+    return result;
+}
+
+
+
+/**
+ * Method: Writes a file's contents, up to inode.size, to a host
+ *  descriptor without copying them. Blocks that are cached go out
+ *  with one writev per batch straight from the cache buffers; runs
+ *  of contiguous blocks that are not cached are sent from the image
+ *  with disk_send
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int fd - the descriptor to write to
+ *
+ * Return: int
+ */
+int file_stream( fs_t * fs, int inodeNum, int fd )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i = 0;
+    int k;
+    int bs = fs->superBlock.blockSize;
+    int numBlock = ( fs->inode[inodeNum].size + bs - 1 ) / bs;
+    int numIov = 0;
+    int result = 0;
+    //  Pin at most half the cache so lookups can still evict
+    int batch = cache_capacity( &fs->cache ) / 2;
+    long iovMax = sysconf( _SC_IOV_MAX );
+    int * pinned;
+    //  char *(s)
+    char * zero = NULL;
+    //  iovec(s)
+    struct iovec * iov;
+    
+    if( iovMax > 0 && batch > iovMax )
+    {
+        batch = iovMax;
+    }
+    
+    if( batch < 1 )
+    {
+        batch = 1;
+    }
+    
+    iov = malloc( batch * sizeof( struct iovec ));
+    pinned = malloc( batch * sizeof( int ));
+    
+    if( iov == NULL || pinned == NULL )
+    {
+        free( iov );
+        free( pinned );
+        
+        return -1;
+    }
+    
+    while( i < numBlock && result == 0 )
+    {
+        int block = bmap_get( fs, inodeNum, i );
+        int len = ( i == numBlock - 1 ) ? fs->inode[inodeNum].size - i * bs : bs;
+        char * data = ( block != 0 ) ? cache_find( &fs->cache, block ) : NULL;
+        
+        if( data != NULL || block == 0 ) //IF: Cached, or a hole that reads as zeros
+        {
+            if( data == NULL && zero == NULL && ( zero = calloc( bs, 1 )) == NULL )
+            {
+                result = -1;
+                
+                break;
+            }
+            
+            iov[numIov].iov_base = ( data != NULL ) ? data : zero;
+            iov[numIov].iov_len = len;
+            pinned[numIov++] = ( data != NULL ) ? block : 0;
+            i++;
+        }
+        else //ELSE: Send the uncached run from the image
+        {
+            int run = 1;
+            
+            while( i + run < numBlock && bmap_get( fs, inodeNum, i + run ) == block + run && !cache_has( &fs->cache, block + run ))
+            {
+                run++;
+            }
+            
+            //  Earlier cached blocks go first to keep the order
+            if( numIov > 0 )
+            {
+                result = disk_write_out( fd, iov, numIov );
+                
+                for( k = 0; k < numIov; k++ )
+                {
+                    cache_release( &fs->cache, pinned[k], 0 );
+                }
+                
+                numIov = 0;
+            }
+            
+            if( result == 0 )
+            {
+                long long bytes = ( i + run == numBlock ) ? ( long long ) fs->inode[inodeNum].size - ( long long ) i * bs : ( long long ) run * bs;
+                
+                result = disk_send( &fs->disk, fd, block, bytes );
+            }
+            
+            i += run;
+        }
+        
+        if( numIov == batch || ( i == numBlock && numIov > 0 ))
+        {
+            result = disk_write_out( fd, iov, numIov );
+            
+            for( k = 0; k < numIov; k++ )
+            {
+                cache_release( &fs->cache, pinned[k], 0 );
+            }
+            
+            numIov = 0;
+        }
+    }
+    
+    for( k = 0; k < numIov; k++ )
+    {
+        cache_release( &fs->cache, pinned[k], 0 );
+    }
+    
+    free( iov );
+    free( pinned );
+    free( zero );
+    
+    return result;
+}
+
+
+
+/**
+ * Method: When this Method is called it will use the
+ *  'cat' command which just outputs the files contents;
+ *  Provided by the Professor
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char * path - path of the file to read /cat from
+ *
+ * Return: int
+ */
+int file_cat( fs_t * fs, char * path )
+{
+    //---VARIABLE(S)---
+    //  integer(s)
+    int inodeNum = 0;
+    //  iovec(s)
+    struct iovec iov;
+    
+    //  Gets the inode of the file
+    pthread_rwlock_rdlock( &fs->volumeLock );
+    inodeNum = path_lookup( fs, path, 0 );
+    if( inodeNum == -1 ) //IF: inodeNum is -1 it doesn't exist
+    {
+        printf( "File cat error: file does not exist\n");
+        pthread_rwlock_unlock( &fs->volumeLock );
+        
+        return -1;
+    }
+    else //ELSE: inodeNum is > -1 therefore it exist
+    {
+        //  The contents go to the descriptor directly, after what
+        //  stdio already has buffered
+        fflush( stdout );
+        
+        if( fs->inode[inodeNum].flags & INODE_INLINE ) //IF: Printed straight from the inode
+        {
+            iov.iov_base = fs->inode[inodeNum].inlineData;
+            iov.iov_len = fs->inode[inodeNum].size;
+            disk_write_out( STDOUT_FILENO, &iov, 1 );
+        }
+        else
+        {
+            file_stream( fs, inodeNum, STDOUT_FILENO );
+        }
+        
+        printf( "\n" );
+    }
+    
+    inode_touch( fs, inodeNum );
+    inode_unlock( fs, inodeNum );
+    pthread_rwlock_unlock( &fs->volumeLock );
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Loads logical blocks [first, last] of a file into the
+ *  cache, one batched read per physically contiguous run
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int first - the first logical block
+ * @param: int last - the last logical block
+ *
+ * Return: None
+ */
+void file_prefetch( fs_t * fs, int inodeNum, int first, int last )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int block;
+    int run;
+    
+    while( first <= last )
+    {
+        block = bmap_get( fs, inodeNum, first );
+        run = 1;
+        
+        if( block == 0 ) //IF: A hole has nothing to read
+        {
+            first++;
+            
+            continue;
+        }
+        
+        while( first + run <= last && bmap_get( fs, inodeNum, first + run ) == block + run )
+        {
+            run++;
+        }
+        
+        cache_prefetch( &fs->cache, block, run );
+        first += run;
+    }
+}
+
+
+
+/**
+ * Method: Reads ahead of a file read. A read that picks up where the
+ *  last one ended doubles the window, up to READAHEAD_MAX blocks or a
+ *  quarter of the cache, and once the read is within half a window
+ *  of the blocks already loaded the next window is read in one go;
+ *  any other read drops the window so random reads load only the
+ *  blocks they touch. Readers of one file share its record, so it is
+ *  updated under its lock and the blocks are loaded after
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int offset - the first byte read
+ * @param: int size - the number of bytes read
+ *
+ * Return: None
+ */
+void file_readahead( fs_t * fs, int inodeNum, int offset, int size )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int bs = fs->superBlock.blockSize;
+    int first = offset / bs;
+    int last = ( offset + size - 1 ) / bs;
+    int lastBlock = ( fs->inode[inodeNum].size - 1 ) / bs;
+    int max = cache_capacity( &fs->cache ) / 4;
+    int from = 0;
+    int to = -1;
+    //  Readahead *(s)
+    Readahead * ra = &fs->readahead[inodeNum];
+    
+    if( max > READAHEAD_MAX )
+    {
+        max = READAHEAD_MAX;
+    }
+    
+    pthread_mutex_lock( &ra->lock );
+    
+    if( offset == ra->next && ra->window > 0 ) //IF: The scan goes on
+    {
+        ra->window = ( ra->window * 2 < max ) ? ra->window * 2 : max;
+    }
+    else if( offset == ra->next || offset == 0 ) //ELSE IF: A scan starts
+    {
+        ra->window = ( READAHEAD_MIN < max ) ? READAHEAD_MIN : max;
+        ra->ahead = last;
+    }
+    else //ELSE: Random access
+    {
+        ra->window = 0;
+        ra->ahead = last;
+    }
+    
+    ra->next = offset + size;
+    
+    if( ra->window > 0 && ra->ahead - last < ra->window / 2 && ra->ahead < lastBlock )
+    {
+        from = ( ra->ahead > last ) ? ra->ahead + 1 : last + 1;
+        ra->ahead = ( last + ra->window < lastBlock ) ? last + ra->window : lastBlock;
+        to = ra->ahead;
+    }
+    
+    pthread_mutex_unlock( &ra->lock );
+    
+    //  The blocks of the read itself go in one batch as well
+    if( last > first )
+    {
+        file_prefetch( fs, inodeNum, first, last );
+    }
+    
+    if( to >= from )
+    {
+        file_prefetch( fs, inodeNum, from, to );
+    }
+}
+
+
+
+/**
+ * Method: Copies bytes [offset, offset + size) of a file into buf,
+ *  touching only the blocks that hold them; the range is clipped to
+ *  the file size. Holes read as zeros; a block that cannot be read
+ *  ends the copy there
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int offset - the first byte to copy
+ * @param: int size - the number of bytes to copy
+ * @param: char * buf - where the bytes go
+ *
+ * Return: int - the number of bytes copied, or -1 if the first block
+ *      could not be read
+ */
+int file_read_range( fs_t * fs, int inodeNum, int offset, int size, char * buf )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int bs = fs->superBlock.blockSize;
+    int done = 0;
+    //  char *(s)
+    char * data;
+    
+    if( offset < 0 || offset >= fs->inode[inodeNum].size || size <= 0 )
+    {
+        return 0;
+    }
+    
+    if( size > fs->inode[inodeNum].size - offset )
+    {
+        size = fs->inode[inodeNum].size - offset;
+    }
+    
+    if( fs->inode[inodeNum].flags & INODE_INLINE )
+    {
+        memcpy( buf, fs->inode[inodeNum].inlineData + offset, size );
+        
+        return size;
+    }
+    
+    file_readahead( fs, inodeNum, offset, size );
+    
+    while( done < size )
+    {
+        int pos = offset + done;
+        int block = bmap_get( fs, inodeNum, pos / bs );
+        int part = bs - pos % bs;
+        
+        if( part > size - done )
+        {
+            part = size - done;
+        }
+        
+        //  A block that is not mapped reads as zeros
+        if( block == 0 )
+        {
+            memset( buf + done, 0, part );
+        }
+        else if(( data = cache_get( &fs->cache, block )) == NULL )
+        {
+            return ( done > 0 ) ? done : -1;
+        }
+        else
+        {
+            memcpy( buf + done, data + pos % bs, part );
+            cache_release( &fs->cache, block, 0 );
+        }
+        
+        done += part;
+    }
+    
+    return size;
+}
+
+
+
+/**
+ * Method: When this Method is called it will read the
+ *  size passed in from the file offset; Implemented by
+ *  Alan Guilfoyle
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char * name - file name to read from
+ * @param: int offset - the ponit where it will start to read
+ * @param: int size - thw size of bytes to read
+ *
+ * Return: int
+ */
+int file_read( fs_t * fs, char * path, int offset, int size )
+{
+    //---VARIABLE(S)---
+    //  integer(s)
+    int inodeNum = 0;
+    int len;
+    //  char *(s)
+    char * tempContentsHolder = NULL;
+    
+    //ERROR CHECKING
+    if( offset < 0 || size < 0 )
+    {
+        if( offset < 0 && size < 0 )
+        {
+            printf( "File read error: Can not have an offset & size less than 0\n" );
+        }
+        else if( offset < 0 )
+        {
+            printf( "File read error: Can not have an offset less than 0\n" );
+        }
+        else if( size < 0 )
+        {
+            printf( "File read error: Can not have a size less than 0\n" );
+        }
+        
+        return -1;
+    }
+    
+    //  Gets the inode of the file
+    pthread_rwlock_rdlock( &fs->volumeLock );
+    inodeNum = path_lookup( fs, path, 0 );
+    
+    if( inodeNum == -1 ) //IF: ERROR CHECKING - inodeNum is -1 it doesn't exist
+    {
+        printf( "File read error: file does not exist\n");
+        pthread_rwlock_unlock( &fs->volumeLock );
+        
+        return -1;
+    }
+    else if( offset > fs->inode[inodeNum].size ) //ELSE IF: Error - offset greater than size of file
+    {
+        printf( "File read error: The offset is greater than the size of the file contents\n" );
+        inode_unlock( fs, inodeNum );
+        pthread_rwlock_unlock( &fs->volumeLock );
+        
+        return -1;
+    }
+    
+    //  Only the requested bytes are fetched, so the buffer is bounded
+    //  by the request rather than the file
+    if( size > fs->inode[inodeNum].size - offset )
+    {
+        size = fs->inode[inodeNum].size - offset;
+    }
+    
+    tempContentsHolder = malloc( size + 1 );
+    
+    if( tempContentsHolder == NULL )
+    {
+        printf( "File read error: out of memory\n" );
+        inode_unlock( fs, inodeNum );
+        pthread_rwlock_unlock( &fs->volumeLock );
+        
+        return -1;
+    }
+    
+    len = file_read_range( fs, inodeNum, offset, size, tempContentsHolder );
+    inode_touch( fs, inodeNum );
+    inode_unlock( fs, inodeNum );
+    pthread_rwlock_unlock( &fs->volumeLock );
+    
+    if( len < 0 )
+    {
+        printf( "File read error: could not read the file\n" );
+        free( tempContentsHolder );
+        
+        return -1;
+    }
+    
+    //  Written by length so contents with NUL bytes come out whole
+    fwrite( tempContentsHolder, 1, len, stdout );
+    printf( "\n" );
+    
+    //Clear the buffer / array to avoid segfault
+    free( tempContentsHolder );
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: When this Method is called it will write the [size]
+ *      bytes of buf[string] into the file[name] from the
+ *      [offset]; Implemented by Alan Guilfoyle
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char * path - path of the file to write to
+ * @param: int offset - the ponit where it will start to write
+ * @param: int size - how large the buf that will be written
+ * @param: char * buf - the string that will be written
+ *
+ * Return: int
+ */
+int file_write( fs_t * fs, char * path, int offset, int size, char * buf )
+{
+    //---VARIABLE(S)---
+    //  integer(s)
+    int inodeNum = 0;
+    int result;
+    
+    //ERROR CHECKING: that the parameters are valid
+    if( offset < 0 || size < 0 )
+    {
+        if( offset < 0 && size < 0 )
+        {
+            printf( "File write error: Can not have an offset & size less than 0\n" );
+        }
+        else if( offset < 0 )
+        {
+            printf( "File write error: Can not have an offset less than 0\n" );
+        }
+        else
+        {
+            printf( "File write error: Can not have a size less than 0\n" );
+        }
+        
+        return -1;
+    }
+    
+    //  ERROR CHECKING: that the size matches the char * buf size
+    if(( size_t ) size != strlen( buf ))
+    {
+        printf( "File write error: The size you entered doesn't match the length of the buffer string you entered\n" );
+        
+        return -1;
+    }
+    
+    //  Gets the inode of the file, which is written under its exclusive lock
+    pthread_rwlock_rdlock( &fs->volumeLock );
+    inodeNum = path_lookup( fs, path, 1 );
+    
+    if( inodeNum == -1 ) //IF: inodeNum is -1 it doesn't exist
+    {
+        printf( "File write error: file does not exist\n");
+        pthread_rwlock_unlock( &fs->volumeLock );
+        
+        return -1;
+    }
+    
+    if( fs->inode[inodeNum].type != file ) //IF: A directory's blocks are not data
+    {
+        printf( "File write error: This is a directory\n" );
+        result = -1;
+    }
+    else if( offset > fs->inode[inodeNum].size ) //ELSE IF: ERROR CHECKING - offset greater than size of file
+    {
+        printf( "The offset is greater than the size of the file contents\n" );
+        result = -1;
+    }
+    else if(( result = file_write_range( fs, inodeNum, offset, size, buf )) >= 0 )
+    {
+        printf( "File written: %s, offset %d, %d bytes, size %d\n", path, offset, size, fs->inode[inodeNum].size );
+        
+        //Update the last access time for file
+        gettimeofday( &( fs->inode[inodeNum].lastAccess ), NULL );
+        dirty_inode( fs, inodeNum );
+        result = 0;
+    }
+    
+    inode_unlock( fs, inodeNum );
+    pthread_rwlock_unlock( &fs->volumeLock );
+    
+    return result;
+}
+
+
+
+/**
+ * Method: Reads and drops size bytes of a stream, the rest of a
+ *  payload that is not written
+ *
+ * @param: FILE * in - the stream
+ * @param: long long size - the number of bytes
+ *
+ * Return: None
+ */
+void stream_skip( FILE * in, long long size )
+{
+    while( size > 0 && getc( in ) != EOF )
+    {
+        size--;
+    }
+}
+
+
+
+/**
+ * Method: Writes size bytes read from a stream into a file at offset,
+ *  which may be at most the file size, one block at a time, so the
+ *  payload is never held whole; size -1 reads to the end of the
+ *  stream. The first chunk ends on a block boundary, so the rest are
+ *  whole blocks and go into the cache without being read back. All
+ *  size bytes are read even when a write fails. The caller holds the
+ *  inode locked exclusively
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ * @param: int offset - the first byte to write
+ * @param: long long size - the number of bytes, or -1
+ * @param: FILE * in - the stream
+ *
+ * Return: long long - the number of bytes written or -1 on error
+ */
+long long file_write_from( fs_t * fs, int inodeNum, int offset, long long size, FILE * in )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int bs = fs->superBlock.blockSize;
+    int want;
+    int got;
+    //  long long(s)
+    long long done = 0;
+    //  char *(s)
+    char * chunk = malloc( bs );
+    
+    if( chunk == NULL )
+    {
+        stream_skip( in, size );
+        
+        return -1;
+    }
+    
+    while( size < 0 || done < size )
+    {
+        want = bs - ( int )(( offset + done ) % bs );
+        
+        if( size >= 0 && want > size - done )
+        {
+            want = size - done;
+        }
+        
+        if(( got = fread( chunk, 1, want, in )) == 0 )
+        {
+            break;
+        }
+        
+        if( offset + done + got > 0x7FFFFFFF || file_write_range( fs, inodeNum, offset + done, got, chunk ) < 0 )
+        {
+            stream_skip( in, size < 0 ? 0 : size - done - got );
+            done = -1;
+            
+            break;
+        }
+        
+        done += got;
+    }
+    
+    free( chunk );
+    
+    return done;
+}
+
+
+
+/**
+ * Method: Writes a payload read from a stream into a file, the way
+ *  file_write writes its buf; see file_write_from
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char * path - path of the file to write to
+ * @param: int offset - the ponit where it will start to write
+ * @param: long long size - the number of bytes, or -1 for all of in
+ * @param: FILE * in - the stream
+ *
+ * Return: int
+ */
+int file_write_stream( fs_t * fs, char * path, int offset, long long size, FILE * in )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int inodeNum;
+    int result = -1;
+    //  long long(s)
+    long long done;
+    
+    pthread_rwlock_rdlock( &fs->volumeLock );
+    inodeNum = path_lookup( fs, path, 1 );
+    
+    if( inodeNum == -1 ) //IF: inodeNum is -1 it doesn't exist
+    {
+        printf( "File write error: file does not exist\n" );
+        stream_skip( in, size );
+    }
+    else if( fs->inode[inodeNum].type != file ) //ELSE IF: A directory's blocks are not data
+    {
+        printf( "File write error: This is a directory\n" );
+        stream_skip( in, size );
+    }
+    else if( offset < 0 || offset > fs->inode[inodeNum].size ) //ELSE IF: ERROR CHECKING - offset outside the file
+    {
+        printf( "The offset is greater than the size of the file contents\n" );
+        stream_skip( in, size );
+    }
+    else if(( done = file_write_from( fs, inodeNum, offset, size, in )) < 0 )
+    {
+        printf( "File write error: the payload did not fit\n" );
+    }
+    else
+    {
+        printf( "File written: %s, offset %d, %lld bytes, size %d\n", path, offset, done, fs->inode[inodeNum].size );
+        
+        //Update the last access time for file
+        gettimeofday( &( fs->inode[inodeNum].lastAccess ), NULL );
+        dirty_inode( fs, inodeNum );
+        result = ( size < 0 || done == size ) ? 0 : -1;
+    }
+    
+    if( inodeNum != -1 )
+    {
+        inode_unlock( fs, inodeNum );
+    }
+    
+    pthread_rwlock_unlock( &fs->volumeLock );
+    
+    return result;
+}
+
+
+
+/**
+ * Method: Writes the size bytes that follow the command in the
+ *  stream it was read from, a script or standard input, into a file;
+ *  a newline right after them is skipped so the next command can
+ *  start on a line of its own
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char * path - path of the file to write to
+ * @param: int offset - the ponit where it will start to write
+ * @param: long long size - the length of the payload
+ * @param: FILE * in - the command stream
+ *
+ * Return: int
+ */
+int file_write_in( fs_t * fs, char * path, int offset, long long size, FILE * in )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int result;
+    int c;
+    
+    if( size < 0 )
+    {
+        printf( "File write error: Can not have a size less than 0\n" );
+        
+        return -1;
+    }
+    
+    result = file_write_stream( fs, path, offset, size, in );
+    
+    if(( c = getc( in )) != '\n' && c != EOF )
+    {
+        ungetc( c, in );
+    }
+    
+    return result;
+}
+
+
+
+/**
+ * Method: Writes the whole of a host file into a file
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char * path - path of the file to write to
+ * @param: int offset - the ponit where it will start to write
+ * @param: char * host - path of the host file
+ *
+ * Return: int
+ */
+int file_write_host( fs_t * fs, char * path, int offset, char * host )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int result;
+    //  FILE *(s)
+    FILE * in = fopen( host, "rb" );
+    
+    if( in == NULL )
+    {
+        printf( "File write error: could not open %s\n", host );
+        
+        return -1;
+    }
+    
+    result = file_write_stream( fs, path, offset, -1, in );
+    fclose( in );
+    
+    return result;
+}
+
+
+
+/**
+ * Method: Finds the inode behind a descriptor
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int fd - the descriptor
+ * @param: int * offset - set to the descriptor's offset
+ *
+ * Return: int - the inode, or -1 if fd is not open
+ */
+int open_file_get( fs_t * fs, int fd, int * offset )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int inodeNum = -1;
+    
+    pthread_mutex_lock( &fs->openLock );
+    
+    if( fd >= 0 && fd < OPEN_FILE && fs->openFile[fd].used )
+    {
+        inodeNum = fs->openFile[fd].inodeNum;
+        *offset = fs->openFile[fd].offset;
+    }
+    
+    pthread_mutex_unlock( &fs->openLock );
+    
+    return inodeNum;
+}
+
+
+
+/**
+ * Method: Finds and locks the inode behind a descriptor. The
+ *  descriptor is looked at again once the inode is locked, as it may
+ *  have been closed and its file removed in between; the caller holds
+ *  volumeLock shared
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int fd - the descriptor
+ * @param: int write - 1 to lock the inode exclusively
+ * @param: int * offset - set to the descriptor's offset
+ *
+ * Return: int - the locked inode, or -1 if fd is not open
+ */
+int open_file_lock( fs_t * fs, int fd, int write, int * offset )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int inodeNum = open_file_get( fs, fd, offset );
+    
+    if( inodeNum >= 0 )
+    {
+        inode_lock( fs, inodeNum, write );
+        
+        if( open_file_get( fs, fd, offset ) != inodeNum )
+        {
+            inode_unlock( fs, inodeNum );
+            inodeNum = -1;
+        }
+    }
+    
+    return inodeNum;
+}
+
+
+
+/**
+ * Method: Tells whether any descriptor has a file open
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the file's inode
+ *
+ * Return: int - 1 if it is open
+ */
+int open_file_busy( fs_t * fs, int inodeNum )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int busy = 0;
+    
+    pthread_mutex_lock( &fs->openLock );
+    
+    for( i = 0; i < OPEN_FILE && !busy; i++ )
+    {
+        busy = ( fs->openFile[i].used && fs->openFile[i].inodeNum == inodeNum );
+    }
+    
+    pthread_mutex_unlock( &fs->openLock );
+    
+    return busy;
+}
+
+
+
+/**
+ * Method: Opens a file and gives back a descriptor for file_pread,
+ *  file_pwrite and file_seek, which use the inode found here instead
+ *  of walking the path again; the offset starts at 0
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char * path - path of the file to open
+ *
+ * Return: int - the descriptor or -1
+ */
+int file_open( fs_t * fs, char * path )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int inodeNum;
+    int fd = -1;
+    
+    pthread_rwlock_rdlock( &fs->volumeLock );
+    inodeNum = path_lookup( fs, path, 0 );
+    
+    if( inodeNum == -1 ) //IF: inodeNum is -1 it doesn't exist
+    {
+        printf( "File open error: file does not exist\n" );
+        pthread_rwlock_unlock( &fs->volumeLock );
+        
+        return -1;
+    }
+    
+    if( fs->inode[inodeNum].type == file ) //IF: Directories are not opened
+    {
+        //  Taken while the file is locked, so it cannot be removed first
+        pthread_mutex_lock( &fs->openLock );
+        
+        for( i = 0; i < OPEN_FILE && fd < 0; i++ )
+        {
+            if( !fs->openFile[i].used )
+            {
+                fd = i;
+                fs->openFile[fd].used = 1;
+                fs->openFile[fd].inodeNum = inodeNum;
+                fs->openFile[fd].offset = 0;
+            }
+        }
+        
+        pthread_mutex_unlock( &fs->openLock );
+        
+        if( fd < 0 )
+        {
+            printf( "File open error: %d files are open already\n", OPEN_FILE );
+        }
+        else
+        {
+            bmap_pin( fs, inodeNum );
+            printf( "File opened: %s, fd %d\n", path, fd );
+        }
+    }
+    else
+    {
+        printf( "File open error: This is a directory\n" );
+    }
+    
+    inode_unlock( fs, inodeNum );
+    pthread_rwlock_unlock( &fs->volumeLock );
+    
+    return fd;
+}
+
+
+
+/**
+ * Method: Closes a descriptor from file_open
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int fd - the descriptor
+ *
+ * Return: int
+ */
+int file_close( fs_t * fs, int fd )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int inodeNum = -1;
     
-    //  Ensures that there is enough space to add file
-    if( numBlock > superBlock.freeBlockCount )
-    {
-        printf( "File create error: not enough blocks\n");
-        
-        return -1;
-    }
+    pthread_mutex_lock( &fs->openLock );
     
-    //  Ensures that there are enough iNodes to add file
-    if( superBlock.freeInodeCount < 1 )
+    if( fd >= 0 && fd < OPEN_FILE && fs->openFile[fd].used )
     {
-        printf( "File create error: not enough inodes\n" );
-        
-        return -1;
+        fs->openFile[fd].used = 0;
+        inodeNum = fs->openFile[fd].inodeNum;
     }
     
-    //  Sets random chars for a string based on size inputed
-    char * tmp = ( char * ) malloc( sizeof( int ) * size + 1 );
-    rand_string( tmp, size);
-    printf( "Random String: %s\n", tmp );
-    
-    // Get inode and fill it
-    inodeNum = get_free_inode();
+    pthread_mutex_unlock( &fs->openLock );
     
     if( inodeNum < 0 )
     {
-        printf( "File create error: not enough inode.\n" );
-        free( tmp );
+        printf( "File close error: fd %d is not open\n", fd );
         
         return -1;
     }
     
-    //  Sets type, owner, group
-    inode[inodeNum].type = file; //Is set to 0 for file
-    inode[inodeNum].owner = 1;
-    inode[inodeNum].group = 2;
-    
-    //  Sets time for create & access
-    gettimeofday( &( inode[inodeNum].created ), NULL );
-    gettimeofday( &( inode[inodeNum].lastAccess ), NULL );
-    
-    //  Sets the size and blockCount
-    inode[inodeNum].size = size;
-    inode[inodeNum].blockCount = numBlock;
-    
-    if( hasRemovedBefore == 1 ) //IF: there hasn't been a remove it
-    {
-        //  Search for all entries for first empty spot
-        for( i = 0; i < MAX_DIR_ENTRY; i++ )
-        {
-            if(( curDir.dentry[i].inode == 0 ) && strcmp( curDir.dentry[i].name, "" ) == 0 )
-            {
-                // Add a new file into the current directory entry
-                strncpy( curDir.dentry[i].name, name, strlen( name ));
-                curDir.dentry[i].name[strlen( name )] = '\0';
-                curDir.dentry[i].inode = inodeNum;
-                curDir.numEntry++;
-                
-                // Get data blocks
-                for( i = 0; i < numBlock; i++ )
-                {
-                    int block = get_free_block();
-                    
-                    if(block == -1)
-                    {
-                        printf( "File create error: get_free_block failed\n");
-                        free( tmp );
-                        
-                        return -1;
-                    }
-                    inode[inodeNum].directBlock[i] = block;
-                    
-                    disk_write( block, tmp + ( i * BLOCK_SIZE ));
-                }
-                
-                printf( "File created: %s, inode %d, size %d\n", name, inodeNum, size );
-                free( tmp );
-                
-                return 0;
-            }
-        }
-    }
-    else //ELSE: there hasn't been a remove
-    {
-        // Add a new file into the current directory entry
-        strncpy( curDir.dentry[curDir.numEntry].name, name, strlen( name ));
-        curDir.dentry[curDir.numEntry].name[strlen( name )] = '\0';
-        curDir.dentry[curDir.numEntry].inode = inodeNum;
-        curDir.numEntry++;
-        
-        // Get data blocks
-        for( i = 0; i < numBlock; i++ )
-        {
-            int block = get_free_block();
-            
-            if(block == -1)
-            {
-                printf( "File create error: get_free_block failed\n");
-                free( tmp );
-                
-                return -1;
-            }
-            inode[inodeNum].directBlock[i] = block;
-            
-            disk_write( block, tmp + ( i * BLOCK_SIZE ));
-        }
-        
-        printf( "File created: %s, inode %d, size %d\n", name, inodeNum, size );
-        free( tmp );
-    }
+    bmap_unpin( fs, inodeNum );
     
     return 0;
 }
@@ -354,167 +2221,161 @@ int file_create( char * name, int size )
 
 
 /**
- * Method: When this Method is called it will use the
- *  'cat' command which just outputs the files contents;
- *  Provided by the Professor
+ * Method: Sets where the next read or write without an offset
+ *  starts; it may be at most the file size when it happens
  *
- * @param: char * name - file name to read /cat from
+ * @param: fs_t * fs - the volume
+ * @param: int fd - the descriptor
+ * @param: int offset - the new offset
  *
  * Return: int
  */
-int file_cat( char * name )
+int file_seek( fs_t * fs, int fd, int offset )
 {
     //---VARIABLE(S)---
-    //  integer(s)
-    int i = 0;
-    int inodeNum = 0;
-    int blockNum = 0;
-    //  char[](s)
-    char fileContents[MAX_BLOCK];
+    //  int(s)
+    int result = -1;
     
-    //  Gets the inode of the file
-    inodeNum = search_cur_dir( name );
-    if( inodeNum == -1 ) //IF: inodeNum is -1 it doesn't exist
+    if( offset < 0 )
     {
-        printf( "File cat error: file does not exist\n");
-        
-        //  Free buffer
-        memset( fileContents, 0, sizeof(fileContents));
+        printf( "File seek error: Can not have an offset less than 0\n" );
         
         return -1;
     }
-    else //ELSE: inodeNum is > -1 therefore it exist
+    
+    pthread_mutex_lock( &fs->openLock );
+    
+    if( fd >= 0 && fd < OPEN_FILE && fs->openFile[fd].used )
     {
-        //  Get number of blocks to iterate through
-        blockNum = inode[inodeNum].blockCount;
-        
-        //FOR LOOP: loop through blocks used to get contents
-        for( i = 0; i < blockNum; i++ )
-        {
-            //  Get the directBlock number
-            int block = inode[inodeNum].directBlock[i];
-            
-            //  Pull contents helded in disk at that block
-            disk_read( block, fileContents );
-            
-            //  Print the contents of the file
-            printf( "%s", fileContents );
-        }
-        
-        //  Free buffer
-        memset( fileContents, 0, sizeof(fileContents));
-        printf( "\n" );
+        fs->openFile[fd].offset = offset;
+        result = 0;
     }
     
-    gettimeofday( &( inode[inodeNum].lastAccess ), NULL );
+    pthread_mutex_unlock( &fs->openLock );
     
-    return 0;
+    if( result < 0 )
+    {
+        printf( "File seek error: fd %d is not open\n", fd );
+    }
+    
+    return result;
 }
 
 
 
 /**
- * Method: When this Method is called it will read the
- *  size passed in from the file offset; Implemented by
- *  Alan Guilfoyle
+ * Method: Moves a descriptor's offset past the bytes a read or write
+ *  without an offset went through
  *
- * @param: char * name - file name to read from
- * @param: int offset - the ponit where it will start to read
- * @param: int size - thw size of bytes to read
+ * @param: fs_t * fs - the volume
+ * @param: int fd - the descriptor
+ * @param: int offset - the new offset
+ *
+ * Return: None
+ */
+void open_file_advance( fs_t * fs, int fd, int offset )
+{
+    pthread_mutex_lock( &fs->openLock );
+    fs->openFile[fd].offset = offset;
+    pthread_mutex_unlock( &fs->openLock );
+}
+
+
+
+/**
+ * Method: Reads size bytes through a descriptor. An offset of -1
+ *  reads at the descriptor's offset and moves it past them; any
+ *  other offset leaves it where it is
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int fd - the descriptor
+ * @param: int offset - the point where it will start to read, or -1
+ * @param: int size - the size of bytes to read
  *
  * Return: int
  */
-int file_read( char * name, int offset, int size )
+int file_pread( fs_t * fs, int fd, int offset, int size )
 {
     //---VARIABLE(S)---
-    //  integer(s)
-    int i = 0;
-    int inodeNum = 0;
-    int blockNum = 0;
+    //  int(s)
+    int inodeNum;
+    int cursor;
+    int len;
+    int advance = ( offset == -1 );
     //  char *(s)
-    char fileContents[MAX_BLOCK + MAX_BLOCK];
-    char tempContentsHolder[MAX_BLOCK + MAX_BLOCK];
-    //  other
-    size_t len;
+    char * buf;
     
     //ERROR CHECKING
-    if( offset < 0 || size < 0 )
+    if( offset < -1 || size < 0 )
     {
-        if( offset < 0 && size < 0 )
-        {
-            printf( "File read error: Can not have an offset & size less than 0\n" );
-        }
-        else if( offset < 0 )
-        {
-            printf( "File read error: Can not have an offset less than 0\n" );
-        }
-        else if( size < 0 )
-        {
-            printf( "File read error: Can not have a size less than 0\n" );
-        }
-        
-        //Clear the buffer / array to avoid segfault
-        memset( fileContents, 0, sizeof( fileContents ));
-        memset( tempContentsHolder, 0, sizeof( tempContentsHolder ));
+        printf( "File read error: Can not have an offset or size less than 0\n" );
         
-        return 0;
+        return -1;
     }
     
-    //  Gets the inode of the file
-    inodeNum = search_cur_dir( name );
+    pthread_rwlock_rdlock( &fs->volumeLock );
+    inodeNum = open_file_lock( fs, fd, 0, &cursor );
     
-    if( inodeNum == -1 ) //IF: ERROR CHECKING - inodeNum is -1 it doesn't exist
+    if( inodeNum == -1 )
     {
-        printf( "File read error: file does not exist\n");
-        
-        //Clear the buffer / array to avoid segfault
-        memset( fileContents, 0, sizeof( fileContents ));
-        memset( tempContentsHolder, 0, sizeof( tempContentsHolder ));
+        printf( "File read error: fd %d is not open\n", fd );
+        pthread_rwlock_unlock( &fs->volumeLock );
         
-        return 0;
+        return -1;
     }
-    else //ELSE: inodeNum is > -1 therefore it exist
+    
+    if( advance )
     {
-        //  Get number of blocks to iterate through
-        blockNum = inode[inodeNum].blockCount;
-        
-        //  FOR LOOP: loop through blocks used to get contents
-        for( i = 0; i < blockNum; i++ )
-        {
-            //  Get the directBlock number
-            int block = inode[inodeNum].directBlock[i];
-            
-            //  Pull contents helded in disk at that block
-            disk_read( block, fileContents );
-            //memcpy( fileContents, disk[block], BLOCK_SIZE );
-            
-            strcat( tempContentsHolder, fileContents );
-        }
+        offset = cursor;
+    }
+    
+    if( offset > fs->inode[inodeNum].size ) //IF: Error - offset greater than size of file
+    {
+        printf( "File read error: The offset is greater than the size of the file contents\n" );
+        inode_unlock( fs, inodeNum );
+        pthread_rwlock_unlock( &fs->volumeLock );
         
-        //  Get the size of the file contents
-        len = strlen( tempContentsHolder );
+        return -1;
+    }
+    
+    //  The buffer is bounded by the request rather than the file
+    if( size > fs->inode[inodeNum].size - offset )
+    {
+        size = fs->inode[inodeNum].size - offset;
+    }
+    
+    if(( buf = malloc( size + 1 )) == NULL )
+    {
+        printf( "File read error: out of memory\n" );
+        inode_unlock( fs, inodeNum );
+        pthread_rwlock_unlock( &fs->volumeLock );
         
-        if( offset > len ) //IF: Error - offset greater than size of file
-        {
-            printf( "File read error: The offset is greater than the size of the file contents\n" );
-            
-            //Clear the buffer / array to avoid segfault
-            memset( fileContents, 0, sizeof( fileContents ));
-            memset( tempContentsHolder, 0, sizeof( tempContentsHolder ));
-            
-            return 0;
-        }
-        else //ELSE: Printing out the contents of the string
-        {
-            printf( "%.*s\n", size, ( tempContentsHolder + offset ));
-        }
+        return -1;
+    }
+    
+    len = file_read_range( fs, inodeNum, offset, size, buf );
+    
+    if( advance && len > 0 )
+    {
+        open_file_advance( fs, fd, offset + len );
+    }
+    
+    inode_touch( fs, inodeNum );
+    inode_unlock( fs, inodeNum );
+    pthread_rwlock_unlock( &fs->volumeLock );
+    
+    if( len < 0 )
+    {
+        printf( "File read error: could not read the file\n" );
+        free( buf );
         
-        //Clear the buffer / array to avoid segfault
-        memset( fileContents, 0, sizeof( fileContents ));
-        memset( tempContentsHolder, 0, sizeof( tempContentsHolder ));
+        return -1;
     }
     
-    gettimeofday( &( inode[inodeNum].lastAccess ), NULL );
+    //  Written by length so contents with NUL bytes come out whole
+    fwrite( buf, 1, len, stdout );
+    printf( "\n" );
+    free( buf );
     
     return 0;
 }
@@ -522,267 +2383,81 @@ int file_read( char * name, int offset, int size )
 
 
 /**
- * Method: When this Method is called it will write the [size]
- *      bytes of buf[string] into the file[name] from the
- *      [offset]; Implemented by Alan Guilfoyle
+ * Method: Writes the [size] bytes of buf through a descriptor. An
+ *  offset of -1 writes at the descriptor's offset and moves it past
+ *  them; any other offset leaves it where it is
  *
- * @param: char * name - file name to write to
- * @param: int offset - the ponit where it will start to write
+ * @param: fs_t * fs - the volume
+ * @param: int fd - the descriptor
+ * @param: int offset - the point where it will start to write, or -1
  * @param: int size - how large the buf that will be written
  * @param: char * buf - the string that will be written
  *
  * Return: int
  */
-int file_write( char * name, int offset, int size, char * buf )
+int file_pwrite( fs_t * fs, int fd, int offset, int size, char * buf )
 {
     //---VARIABLE(S)---
-    //  integer(s)
-    int i = 0;
-    int inodeNum = 0;
-    int blockNum = 0;
-    //  char *(s)
-    char temp[MAX_BLOCK + MAX_BLOCK];
-    char temp2[MAX_BLOCK + MAX_BLOCK];
-    char temp3[MAX_BLOCK + MAX_BLOCK];
-    char fileContents[MAX_BLOCK + MAX_BLOCK];
-    char tempContentsHolder[MAX_BLOCK + MAX_BLOCK];
-    //  other
-    size_t len;
+    //  int(s)
+    int inodeNum;
+    int cursor;
+    int result = -1;
+    int advance = ( offset == -1 );
     
     //ERROR CHECKING: that the parameters are valid
-    if( offset < 0 || size < 0 )
+    if( offset < -1 || size < 0 )
     {
-        if( offset < 0 && size < 0 )
-        {
-            printf( "File write error: Can not have an offset & size less than 0\n" );
-        }
-        else if( offset < 0 )
-        {
-            printf( "File write error: Can not have an offset less than 0\n" );
-        }
-        else
-        {
-            printf( "File write error: Can not have a size less than 0\n" );
-        }
+        printf( "File write error: Can not have an offset or size less than 0\n" );
         
-        //  Free buffer
-        memset( temp, 0, sizeof( temp ));
-        memset( temp2, 0, sizeof( temp2 ));
-        memset( temp3, 0, sizeof( temp3 ));
-        memset( fileContents, 0, sizeof( fileContents ));
-        memset( tempContentsHolder, 0, sizeof( tempContentsHolder ));
-        
-        return 0;
+        return -1;
     }
     
     //  ERROR CHECKING: that the size matches the char * buf size
-    if( size != strlen( buf ))
+    if(( size_t ) size != strlen( buf ))
     {
         printf( "File write error: The size you entered doesn't match the length of the buffer string you entered\n" );
         
-        //Error so freeing buffer
-        memset( temp, 0, sizeof( temp ));
-        memset( temp2, 0, sizeof( temp2 ));
-        memset( temp3, 0, sizeof( temp3 ));
-        memset( fileContents, 0, sizeof( fileContents ));
-        memset( tempContentsHolder, 0, sizeof( tempContentsHolder ));
-        
-        return 0;
+        return -1;
     }
     
-    //  Gets the inode of the file
-    inodeNum = search_cur_dir( name );
+    pthread_rwlock_rdlock( &fs->volumeLock );
+    inodeNum = open_file_lock( fs, fd, 1, &cursor );
     
-    if( inodeNum == -1 ) //IF: inodeNum is -1 it doesn't exist
+    if( inodeNum == -1 )
     {
-        printf( "File write error: file does not exist\n");
-        
-        //Error so freeing buffer
-        memset( temp, 0, sizeof( temp ));
-        memset( temp2, 0, sizeof( temp2 ));
-        memset( temp3, 0, sizeof( temp3 ));
-        memset( fileContents, 0, sizeof( fileContents ));
-        memset( tempContentsHolder, 0, sizeof( tempContentsHolder ));
+        printf( "File write error: fd %d is not open\n", fd );
+        pthread_rwlock_unlock( &fs->volumeLock );
         
         return -1;
     }
-    else //ELSE: inodeNum is > -1 therefore it exist
+    
+    if( advance )
     {
-        //  Get number of blocks to iterate through
-        blockNum = inode[inodeNum].blockCount;
-        
-        //  FOR LOOP: loop through blocks used to get contents
-        for( i = 0; i < blockNum; i++ )
-        {
-            //  Get the directBlock number
-            int block = inode[inodeNum].directBlock[i];
-            
-            //  Pull contents helded in disk at that block
-            disk_read( block, fileContents );
-            //memcpy( fileContents, disk[block], BLOCK_SIZE );
-            
-            strcat( tempContentsHolder, fileContents );
-        }
-        
-        //  Get the size of the file contents
-        len = strlen( tempContentsHolder );
+        offset = cursor;
+    }
+    
+    if( offset > fs->inode[inodeNum].size ) //IF: ERROR CHECKING - offset greater than size of file
+    {
+        printf( "The offset is greater than the size of the file contents\n" );
+    }
+    else if( file_write_range( fs, inodeNum, offset, size, buf ) >= 0 )
+    {
+        printf( "File written: fd %d, offset %d, %d bytes, size %d\n", fd, offset, size, fs->inode[inodeNum].size );
         
-        if( offset > len ) //IF: ERROR CHECKING - offset greater than size of file
-        {
-            printf( "The offset is greater than the size of the file contents\n" );
-            
-            //Error so freeing buffer
-            memset( temp, 0, sizeof( temp ));
-            memset( temp2, 0, sizeof( temp2 ));
-            memset( temp3, 0, sizeof( temp3 ));
-            memset( fileContents, 0, sizeof( fileContents ));
-            memset( tempContentsHolder, 0, sizeof( tempContentsHolder ));
-            
-            return 0;
-        }
-        else //ELSE: Printing out the contents of the string
+        if( advance )
         {
-            //  Will grab the string of the string prior to the start of the offset
-            sprintf( temp3, "%.*s", offset, ( tempContentsHolder ));
-            //  Will grab the string that is passed in to be appended
-            sprintf( temp, "%s", buf );
-            //  Concat the two strings together
-            strcat( temp3, temp );
-            
-            //  Will grab the rest of the string starting from the offset + size
-            sprintf( temp2, "%s", ( tempContentsHolder + offset + size ));
-            //  Concat the two strings together
-            strcat( temp3, temp2 );
-            //  Will print the new string with the passed in string added
-            printf( "%s\n", temp3 );
-            
-            if( inode[inodeNum].size == strlen( temp3 )) //IF: Size was not changed enter
-            {
-                int k = 0;
-                for( k = 0; k < blockNum; k++ )
-                {
-                    int block = inode[inodeNum].directBlock[k];
-                    
-                    disk_write( block, temp3 + ( k * BLOCK_SIZE ));
-                }
-            }
-            else //ELSE: Size was changed
-            {
-                if( strlen( temp3 ) >= SMALL_FILE )
-                {
-                    printf( "File write error: Do not support files larger than %d bytes yet.\n", SMALL_FILE );
-                    
-                    //Error so freeing buffer
-                    memset( temp, 0, sizeof( temp ));
-                    memset( temp2, 0, sizeof( temp2 ));
-                    memset( temp3, 0, sizeof( temp3 ));
-                    memset( fileContents, 0, sizeof( fileContents ));
-                    memset( tempContentsHolder, 0, sizeof( tempContentsHolder ));
-                    
-                    return -1;
-                }
-                
-                //  Sets initalizied number of blocks
-                int newBlockNum = ( size + strlen( tempContentsHolder )) / BLOCK_SIZE;
-                //  Adds to the size depending on the file size
-                if(( size + strlen( tempContentsHolder )) % BLOCK_SIZE > 0 )
-                {
-                    newBlockNum++;
-                }
-                
-                if( newBlockNum == blockNum ) //IF: block number didn't change from old block numbers
-                {
-                    //Assign the new size of concatenated string to file
-                    inode[inodeNum].size = strlen( temp3 );
-                    
-                    int k = 0;
-                    for( k = 0; k < blockNum; k++ )
-                    {
-                        int block = inode[inodeNum].directBlock[k];
-                        
-                        disk_write( block, temp3 + ( k * BLOCK_SIZE ));
-                    }
-                }
-                else //ELSE: else block number increased from orginal block numbers
-                {
-                    int count = 0;
-                    //Get the difference to see if we have enough free blocks
-                    int blockDifference = newBlockNum - blockNum;
-                    
-                    //ERROR CHECKING: Ensures that there is enough space
-                    if( blockDifference > superBlock.freeBlockCount )
-                    {
-                        printf( "File write error: File create failed: not enough space\n");
-                        
-                        //Error so freeing buffer
-                        memset( temp, 0, sizeof( temp ));
-                        memset( temp2, 0, sizeof( temp2 ));
-                        memset( temp3, 0, sizeof( temp3 ));
-                        memset( fileContents, 0, sizeof( fileContents ));
-                        memset( tempContentsHolder, 0, sizeof( tempContentsHolder ));
-                        
-                        return -1;
-                    }
-                    
-                    //Assign the new size of concatenated string to file
-                    inode[inodeNum].size = strlen( temp3 );
-                    
-                    //Assign the number of new blocks used to the inode
-                    inode[inodeNum].blockCount = newBlockNum;
-                    
-                    int k = 0;
-                    for( k = 0; k < newBlockNum; k++ )
-                    {
-                        if( count != blockDifference ) //IF: Replace data in old blocks
-                        {
-                            int block = inode[inodeNum].directBlock[k];
-                            
-                            disk_write( block, temp3 + ( k * BLOCK_SIZE ));
-                            
-                            count++;
-                        }
-                        else //ELSE: Get new data blocks and place the rest there
-                        {
-                            int block = get_free_block();
-                            
-                            //ERROR CHECKING: Ensures that the block was created
-                            if(block == -1)
-                            {
-                                printf( "File write error: get_free_block failed\n");
-                                
-                                //Error so freeing buffer
-                                memset( temp, 0, sizeof( temp ));
-                                memset( temp2, 0, sizeof( temp2 ));
-                                memset( temp3, 0, sizeof( temp3 ));
-                                memset( fileContents, 0, sizeof( fileContents ));
-                                memset( tempContentsHolder, 0, sizeof( tempContentsHolder ));
-                                
-                                return -1;
-                            }
-                            
-                            //Assign direct block to inode
-                            inode[inodeNum].directBlock[k] = block;
-                            //Write the rest of the data to block
-                            disk_write( block, temp3 + ( k * BLOCK_SIZE ));
-                        }
-                    }
-                }
-            }
+            open_file_advance( fs, fd, offset + size );
         }
         
-        //Update the last access time for file
-        gettimeofday( &( inode[inodeNum].lastAccess ), NULL );
-        //Update the last access time for
-        
-        //Clear the buffer / array to avoid segfault
-        memset( temp, 0, sizeof( temp ));
-        memset( temp2, 0, sizeof( temp2 ));
-        memset( temp3, 0, sizeof( temp3 ));
-        memset( fileContents, 0, sizeof( fileContents ));
-        memset( tempContentsHolder, 0, sizeof( tempContentsHolder ));
+        gettimeofday( &( fs->inode[inodeNum].lastAccess ), NULL );
+        dirty_inode( fs, inodeNum );
+        result = 0;
     }
     
-    return 0;
+    inode_unlock( fs, inodeNum );
+    pthread_rwlock_unlock( &fs->volumeLock );
+    
+    return result;
 }
 
 
@@ -792,77 +2467,83 @@ int file_write( char * name, int offset, int size, char * buf )
  *  off the file name sent through the parameters; It will free the 
  *  inode, data block, etc.
  *
- * @param: char * name - is the name of the file that will be removed
+ * @param: fs_t * fs - the volume
+ * @param: char * path - is the path of the file that will be removed
  *
  * Return: int
  */
-int file_remove( char * name )
+int file_remove( fs_t * fs, char * path )
 {
     //---VARIABLE(S)---
     //  int(s)
-    int inodeNum = 0;
-    int i = 0;
-    int counter = 0;
+    int inodeNum = -1;
+    int dirInode;
+    int result = 0;
+    //  char(s)
+    char name[MAX_FILE_NAME];
     
-    //  Search directory if file already exist
-    inodeNum = search_cur_dir( name );
+    pthread_rwlock_rdlock( &fs->volumeLock );
     
-    //  ERROR CHECK: check to see if file exist
-    if( inodeNum < 0 )
+    //  Search directory if file already exist
+    if( path_parent( fs, path, &dirInode, name ) < 0 )
     {
-        printf( "File remove failed:  %s file doesn't exist.\n", name );
+        printf( "File remove failed:  %s file doesn't exist.\n", path );
+        pthread_rwlock_unlock( &fs->volumeLock );
         
         return -1;
     }
     
-    if( inode[inodeNum].type == file ) //IF: type is file
+    //  The directory, then the file, are held exclusively
+    inode_lock( fs, dirInode, 1 );
+    inodeNum = dir_lookup( fs, dirInode, name );
+    
+    //  ERROR CHECK: check to see if file exist
+    if( inodeNum < 0 )
     {
-        for( i = 0; i < MAX_DIR_ENTRY; i++ )
+        printf( "File remove failed:  %s file doesn't exist.\n", path );
+        result = -1;
+    }
+    else if( fs->inode[inodeNum].type == file ) //IF: type is file
+    {
+        //  Descriptors are only added under the file's lock, so once it
+        //  is held no new one can show up
+        inode_lock( fs, inodeNum, 1 );
+        
+        if( open_file_busy( fs, inodeNum )) //IF: A descriptor still uses it
         {
-            if( curDir.dentry[i].inode == inodeNum )
-            {
-                //  Set global varaible 'hasRemovedBefore' to 1 (true)
-                hasRemovedBefore = 1;
-                
-                //  Making entry name blank
-                strncpy( curDir.dentry[i].name, "", strlen( "" ));
-                curDir.dentry[i].name[strlen( "" )] = '\0';
-                
-                //Change entry inode to -1
-                curDir.dentry[i].inode = 0;
-                
-                //  Set inodemap spot to 0 and increment freeInodeCount
-                set_bit(inodeMap, inodeNum, 0);
-                superBlock.freeInodeCount++;
-                
-                //  Decrement the number of entries present
-                curDir.numEntry--;
-
-                //  Get the number of blocks used and cycle through
-                int numBlock = inode[inodeNum].blockCount;
-                for( i = 0; i < numBlock; i++ )
-                {
-                    set_bit(blockMap, inode[inodeNum].directBlock[i], 0);
-                }
-                
-                //  Increment the free block count
-                superBlock.freeBlockCount = numBlock + superBlock.freeBlockCount;
-                
-                //  Set access time of directory, though this doesn't matter
-                gettimeofday( &( inode[inodeNum].lastAccess ), NULL );
-                
-                break;
-            }
+            printf( "File remove error: %s is open\n", path );
+            result = -1;
+        }
+        else
+        {
+            //  Take the entry out of its directory
+            dir_delete( fs, dirInode, name );
+            
+            //  Free every data and indirect block, which increments
+            //  the free block count
+            bmap_free( fs, inodeNum );
+            
+            //  Set access time of directory, though this doesn't matter
+            gettimeofday( &( fs->inode[inodeNum].lastAccess ), NULL );
+            dirty_inode( fs, inodeNum );
+            
+            //  Set inodemap spot to 0 and increment freeInodeCount; last,
+            //  as a create elsewhere may take the inode from here on
+            put_free_inode( fs, inodeNum );
         }
+        
+        inode_unlock( fs, inodeNum );
     }
     else //ELSE: ERROR CHECK - type is directory
     {
         printf( "File remove error: This is a directory, can't delete it\n" );
-        
-        return -1;
+        result = -1;
     }
     
-    return 0;
+    inode_unlock( fs, dirInode );
+    pthread_rwlock_unlock( &fs->volumeLock );
+    
+    return result;
 }
 
 
@@ -870,29 +2551,36 @@ int file_remove( char * name )
 /**
  * Method: Provided by the Professor; Provides the stats of the file/directory
  *
- * @param: char * name - the name of the file that you have to look up stats for
+ * @param: fs_t * fs - the volume
+ * @param: char * path - the path of the file that you have to look up stats for
  *
  * Return: int
  */
-int file_stat( char * name )
+int file_stat( fs_t * fs, char * path )
 {
     //---VARIABLE(S)---
     //  int(s)
-    int inodeNum = search_cur_dir( name );
+    int inodeNum;
     //  char(s)
     char timebuf[28];
+    //  timeval(s)
+    struct timeval lastAccess;
+    
+    pthread_rwlock_rdlock( &fs->volumeLock );
+    inodeNum = path_lookup( fs, path, 0 );
     
     //  ERROR CHECKING
     if( inodeNum < 0 ) //IF: inode return is below 0
     {
         printf( "File cat error: file is not exist.\n" );
+        pthread_rwlock_unlock( &fs->volumeLock );
         
         return -1;
     }
     
     //  Print out the stats of the directory / file
     printf( "Inode = %d\n", inodeNum );
-    if( inode[inodeNum].type == file )
+    if( fs->inode[inodeNum].type == file )
     {
         printf( "%d\n", file );
         printf( "type = file\n" );
@@ -902,42 +2590,54 @@ int file_stat( char * name )
         printf( "type = directory\n");
     }
     
-    printf( "owner = %d\n", inode[inodeNum].owner );
-    printf( "group = %d\n", inode[inodeNum].group );
-    printf( "size = %d\n", inode[inodeNum].size );
-    printf( "num of block = %d\n", inode[inodeNum].blockCount );
+    printf( "owner = %d\n", fs->inode[inodeNum].owner );
+    printf( "group = %d\n", fs->inode[inodeNum].group );
+    printf( "size = %d\n", fs->inode[inodeNum].size );
+    printf( "num of block = %d\n", fs->inode[inodeNum].blockCount );
+    
+    if( fs->inode[inodeNum].flags & INODE_INLINE )
+    {
+        printf( "data = inline\n" );
+    }
+    else if( fs->inode[inodeNum].flags & INODE_EXTENTS )
+    {
+        printf( "num of extent = %d%s\n", fs->inode[inodeNum].extentCount, fs->inode[inodeNum].extentTree ? " (tree)" : "" );
+    }
     
-    format_timeval( &( inode[inodeNum].created ), timebuf, 28 );
+    format_timeval( &( fs->inode[inodeNum].created ), timebuf, 28 );
     printf( "Created time = %s\n", timebuf );
     
-    format_timeval( &( inode[inodeNum].lastAccess ), timebuf, 28 );
+    //  Readers may be setting it under the shared lock
+    pthread_mutex_lock( &fs->readahead[inodeNum].lock );
+    lastAccess = fs->inode[inodeNum].lastAccess;
+    pthread_mutex_unlock( &fs->readahead[inodeNum].lock );
+    
+    format_timeval( &lastAccess, timebuf, 28 );
     printf( "Last accessed time = %s\n", timebuf );
     
+    inode_unlock( fs, inodeNum );
+    pthread_rwlock_unlock( &fs->volumeLock );
+    
     return 0;
 }
 
 
 
 /**
- * Method: when called it will take in a name that will be the name
- *  of the new directory that this Method will create; Implemented by
- *  Alan Guilfoyle.
+ * Method: Makes a directory in a directory the caller holds locked
+ *  exclusively
  *
- * @param: char * name - file name to make the directory
+ * @param: fs_t * fs - the volume
+ * @param: int dirInode - the parent directory
+ * @param: char * name - the new directory's name
  *
  * Return: int
  */
-int dir_make( char * name )
+int dir_make_in( fs_t * fs, int dirInode, char * name )
 {
     //---VARIABLE(S)---
-    //  integer(s)
-    int i;
-    int parentDirInode;
-    int currentDirInode;
-    int oldCurDirBlock;
-    
-    //  Returns -1 or existing inode number
-    int inodeNum = search_cur_dir( name );
+    //  int(s)
+    int inodeNum = dir_lookup( fs, dirInode, name ); // -1 or existing inode number
     
     //  ERROR CHECK: Ensures that directory doesn't already exist
     if(inodeNum >= 0)
@@ -947,16 +2647,8 @@ int dir_make( char * name )
         return -1;
     }
     
-    //  ERROR CHECK: Ensures that there are enough directory entries
-    if( curDir.numEntry + 1 > ( BLOCK_SIZE / sizeof( DirectoryEntry )))
-    {
-        printf( "Directory create failed: directory is full!\n" );
-        
-        return -1;
-    }
-    
     //  ERROR CHECK: Ensures that there are enough iNodes to add file
-    if( superBlock.freeInodeCount < 1 )
+    if( __atomic_load_n( &fs->superBlock.freeInodeCount, __ATOMIC_RELAXED ) < 1 )
     {
         printf( "Directory create failed: not enough inodes\n" );
         
@@ -964,7 +2656,7 @@ int dir_make( char * name )
     }
     
     //  Get new inode for directory
-    int directoryInode = get_free_inode();
+    int directoryInode = get_free_inode( fs );
     //  ERROR CHECK: Ensures one free inode
     if( directoryInode < 0 )
     {
@@ -973,114 +2665,83 @@ int dir_make( char * name )
         return -1;
     }
     
-    oldCurDirBlock = curDirBlock;
+    //*********************************
+    //***STEP 1: CREATE NEW DIRECTORY
+    //  Sets type, owner, group
+    fs->inode[directoryInode].type = directory; //Is set to 1 for directory
+    fs->inode[directoryInode].owner = 1;
+    fs->inode[directoryInode].group = 2;
+    bmap_init( fs, directoryInode, 0 );
+    
+    gettimeofday( &( fs->inode[directoryInode].created ), NULL );
+    gettimeofday( &( fs->inode[directoryInode].lastAccess ), NULL );
+    
+    //  Set size; dir_init gives it its first block with '.' and '..'
+    fs->inode[directoryInode].size = 1;
+    dirty_inode( fs, directoryInode );
     
-    //  Gets a free block
-    curDirBlock = get_free_block();
-    //  ERROR CHECK: Ensures one free block out of the 10
-    if( curDirBlock == -1 )
+    if( dir_init( fs, directoryInode, dirInode ) < 0 )
     {
         printf( "Directory create error: get_free_block failed\n");
+        put_free_inode( fs, directoryInode );
         
         return -1;
     }
     
     //*********************************
-    //***STEP 1: CREATE NEW DIRECTORY & WRITE
-    //  Sets type, owner, group
-    inode[directoryInode].type = directory; //Is set to 1 for directory
-    inode[directoryInode].owner = 1;
-    inode[directoryInode].group = 2;
-    
-    gettimeofday( &( inode[directoryInode].created ), NULL );
-    gettimeofday( &( inode[directoryInode].lastAccess ), NULL );
-    
-    //  Set size, blockCount and directBlock
-    inode[directoryInode].size = 1;
-    inode[directoryInode].blockCount = 1;
-    inode[directoryInode].directBlock[0] = curDirBlock;
-    
-    if( hasRemovedBefore == 1 ) //IF: there hasn't been a remove it
+    //***STEP 2: ADD IT TO ITS PARENT DIRECTORY
+    if( dir_add( fs, dirInode, name, directoryInode ) < 0 )
     {
-        //  Search for all entries for first empty spot
-        for( i = 0; i < MAX_DIR_ENTRY; i++ )
-        {
-            if(( curDir.dentry[i].inode == 0 ) && strcmp( curDir.dentry[i].name, "" ) == 0 )
-            {
-                //  Set the parents directory inode
-                parentDirInode = currentDirectoryInode;
-                
-                //  Set the name of the directory
-                strncpy( curDir.dentry[i].name, name, strlen( name ));
-                curDir.dentry[i].name[strlen( name )] = '\0';
-                
-                //  Set the inode of the directory
-                curDir.dentry[i].inode = directoryInode;
-                currentDirInode = directoryInode;
-                
-                //  Increment the numEntries
-                curDir.numEntry++;
-
-                break;
-            }
-        }
-    }
-    else //ELSE: there hasn't been a remove
-    {
-        //  Set the parents directory inode
-        parentDirInode = currentDirectoryInode;
-        
-        //  Set the name of the directory
-        strncpy( curDir.dentry[curDir.numEntry].name, name, strlen( name ));
-        curDir.dentry[curDir.numEntry].name[strlen( name )] = '\0';
-        
-        //  Set the inode of the directory
-        curDir.dentry[curDir.numEntry].inode = directoryInode;
-        currentDirInode = directoryInode;
+        printf( "Directory create failed: directory is full!\n" );
+        bmap_free( fs, directoryInode );
+        put_free_inode( fs, directoryInode );
         
-        //  Increment the numEntries
-        curDir.numEntry++;
+        return -1;
     }
     
-    //  Write all of this new information to disk
-    disk_write( oldCurDirBlock, ( char* ) &curDir );
-    
-    //*********************************
-    //***STEP 2: INITALIZE THE NEW DIRECTORY & WRITE
-    //  Resets curDir so it can be reused
-    bzero( &curDir, sizeof( curDir ));
-    
-    //  Set numEntry to zero
-    curDir.numEntry = 0;
-    
-    //  Set up '.' for new directory
-    strncpy( curDir.dentry[curDir.numEntry].name, ".", 1);
-    curDir.dentry[curDir.numEntry].name[1] = '\0';
-    //  Set the inode of the directory
-    curDir.dentry[curDir.numEntry].inode = currentDirInode;
-    curDir.numEntry++;
-    
-    //  Set up '..' for parent directory
-    strncpy( curDir.dentry[curDir.numEntry].name, "..", 2);
-    curDir.dentry[curDir.numEntry].name[2] = '\0';
-    //  Set the inode of the directory
-    curDir.dentry[curDir.numEntry].inode = parentDirInode;
-    curDir.numEntry++;
+    //  Print the recently created directory information
+    printf( "Directory created: %s, inode %d, size %d\n", name, directoryInode, fs->inode[directoryInode].size );
     
-    //  Write information for this new directory to disk
-    disk_write( inode[directoryInode].directBlock[0], ( char* ) &curDir );
+    return 0;
+}
+
+
+
+/**
+ * Method: when called it will take in a name that will be the name
+ *  of the new directory that this Method will create; its parent is
+ *  locked exclusively throughout; Implemented by Alan Guilfoyle.
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char * path - path of the directory to make
+ *
+ * Return: int
+ */
+int dir_make( fs_t * fs, char * path )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int dirInode;
+    int result;
+    //  char(s)
+    char name[MAX_FILE_NAME];
     
+    pthread_rwlock_rdlock( &fs->volumeLock );
     
-    //*********************************
-    //***STEP 3: REREAD THE OLD
-    //  Read from disk to reload old directory
-    disk_read( oldCurDirBlock, ( char* )&curDir );
-    curDirBlock = oldCurDirBlock;
+    if( path_parent( fs, path, &dirInode, name ) < 0 )
+    {
+        printf( "Directory create failed: parent directory does not exist.\n" );
+        pthread_rwlock_unlock( &fs->volumeLock );
+        
+        return -1;
+    }
     
-    //  Print the recently created directory information
-    printf( "Directory created: %s, inode %d, size %d\n", name, directoryInode, inode[directoryInode].size );
+    inode_lock( fs, dirInode, 1 );
+    result = dir_make_in( fs, dirInode, name );
+    inode_unlock( fs, dirInode );
+    pthread_rwlock_unlock( &fs->volumeLock );
     
-    return 0;
+    return result;
 }
 
 
@@ -1088,95 +2749,92 @@ int dir_make( char * name )
 /**
  * Method: Will remove a specified directory; Implemented by Alan Guilfoyle
  *
- * @param: char * name
+ * @param: fs_t * fs - the volume
+ * @param: char * path
  *
  * Return: int
  */
-int dir_remove( char * name )
+int dir_remove( fs_t * fs, char * path )
 {
     //---VARIABLE(S)---
     //  int(s)
-    int i;
-    int j;
+    int dirInode;
+    int directoryInodeNum = -1;
+    //  char(s)
+    char name[MAX_FILE_NAME];
+    
+    //  Nothing else runs while a directory goes away, so no walk can be
+    //  on its way through it
+    pthread_rwlock_wrlock( &fs->volumeLock );
+    
+    if( path_parent( fs, path, &dirInode, name ) == 0 )
+    {
+        directoryInodeNum = dir_lookup( fs, dirInode, name );
+    }
     
     //  ERROR CHECKING: Making sure you don't remove parent or current directory
     if( strcmp( name, "." ) == 0 )
     {
         printf( "Directory remove error: Can't remove the directory you are in.\n" );
+        pthread_rwlock_unlock( &fs->volumeLock );
         
         return -1;
     }
     else if( strcmp( name, ".." ) == 0 )
     {
         printf( "Directory remove error: Can't remove parent directory because it contains files.\n" );
+        pthread_rwlock_unlock( &fs->volumeLock );
         
         return -1;
     }
     
-    int directoryInodeNum = search_cur_dir( name );
-    
     //  ERROR CHECKING: Making sure the directory exist
     if( directoryInodeNum < 0 )
     {
         printf( "Directory remove error: directory does not exist.\n" );
+        pthread_rwlock_unlock( &fs->volumeLock );
         
         return -1;
     }
-    
-    if( inode[directoryInodeNum].type == directory )
+    else if( directoryInodeNum == fs->currentDirectoryInode )
     {
-        //Check to see if there are any files in the directory
-        //CD into directory to check and see if any files are present
-        dir_change( name );
+        printf( "Directory remove error: Can't remove the directory you are in.\n" );
+        pthread_rwlock_unlock( &fs->volumeLock );
         
-        //  ERROR CHECKING
-        if( curDir.numEntry > 2 ) //IF: number of entries is less than 2
+        return -1;
+    }
+    
+    if( fs->inode[directoryInodeNum].type == directory )
+    {
+        //  ERROR CHECKING: only '.' and '..' may be left
+        if( dir_count( fs, directoryInodeNum ) > 2 )
         {
             printf( "Directory remove error: The directory has files in it. Cannot remove\n" );
-            
-            dir_change( ".." );
+            pthread_rwlock_unlock( &fs->volumeLock );
             
             return -1;
         }
         
-        //  Made it out the loop, we can remove directory; Enter into parent directory
-        dir_change( ".." );
+        //  Take the entry out of its parent
+        dir_delete( fs, dirInode, name );
         
-        //  Making entry name blank
-        hasRemovedBefore = 1;
+        //  Change inodeMap to 0 and increase inode count
+        put_free_inode( fs, directoryInodeNum );
         
-        //  Will loop through entir number of entries to find directory
-        for( j = 0; j < MAX_DIR_ENTRY; j++ )
-        {
-            if( curDir.dentry[j].inode == directoryInodeNum )
-            {
-                //  Set name to blank string
-                strncpy( curDir.dentry[j].name, "", strlen( "" ));
-                curDir.dentry[j].name[strlen( "" )] = '\0';
-                
-                //  Change inode to 0
-                curDir.dentry[j].inode = 0;
-                
-                //  Change inodeMap to 0 and increase inode count
-                set_bit(inodeMap, directoryInodeNum, 0);
-                superBlock.freeInodeCount++;
-                
-                //  Change blockMap to 0 and increase block count
-                set_bit(blockMap, inode[directoryInodeNum].directBlock[i], 0);
-                superBlock.freeBlockCount++;
-                
-                //  Decrement the number of numEntries for directory
-                curDir.numEntry--;
-            }
-        }
+        //  Change blockMap to 0 and increase block count for every
+        //  block of the directory, its index included
+        bmap_free( fs, directoryInodeNum );
     }
     else //ELSE: It's a file you must use rm to remove that
     {
         printf( "Directory remove error: You are trying to remove a file. Please check the name of the directory and try again.\n");
+        pthread_rwlock_unlock( &fs->volumeLock );
         
         return -1;
     }
     
+    pthread_rwlock_unlock( &fs->volumeLock );
+    
     return 0;
 }
 
@@ -1185,12 +2843,17 @@ int dir_remove( char * name )
 /**
  * Method: Will change into a specified directory; Implemented by Alan Guilfoyle
  *
- * @param: char * name
+ * @param: fs_t * fs - the volume
+ * @param: char * name - a name or a path
  *
  * Return: int
  */
-int dir_change( char * name )
+int dir_change( fs_t * fs, char * name )
 {
+    //---VARIABLE(S)---
+    //  int(s)
+    int parent;
+    
     if( strcmp( name, "." ) == 0  ) //IF: user types '.'
     {
         printf( "Change directory error: Currently in this directory\n" );
@@ -1199,82 +2862,60 @@ int dir_change( char * name )
     }
     else if( strcmp( name, ".." ) == 0  ) //ELSE IF: user types '..'
     {
-        //*********************************
-        //  STEP 1: GET INODE & curDirBlock OF CURRENT & PARENT DIRECTORY
-        int changeFromDirectoryInode = search_cur_dir( "." );
-        int changeFromDirectoryCurDirBlock = inode[changeFromDirectoryInode].directBlock[0];
-        int changeToParentDirectoryInode = search_cur_dir( ".." );
-        int changeToParentDirectoryCurDirBlock = inode[changeToParentDirectoryInode].directBlock[0];
+        //  Path walks start from the current directory, so it only
+        //  changes while none of them runs
+        pthread_rwlock_wrlock( &fs->volumeLock );
         
         //  ERROR CHECKING: making sure that they aren't in root directory trying to use '..'
-        if( changeFromDirectoryInode == 0 )
+        if( fs->currentDirectoryInode == 0 )
         {
             printf( "Change directory error: Currently in this directory\n" );
+            pthread_rwlock_unlock( &fs->volumeLock );
             
             return 0;
         }
         
-        //*********************************
-        //  STEP 2: WRITE NEW FILES / INFORMATION TO DISK
-        disk_write( changeFromDirectoryCurDirBlock, ( char* )&curDir );
-        
+        //  Set global variable that holds current directory's inode
+        inode_lock( fs, fs->currentDirectoryInode, 0 );
+        parent = dir_lookup( fs, fs->currentDirectoryInode, ".." );
+        inode_unlock( fs, fs->currentDirectoryInode );
+        fs->currentDirectoryInode = parent;
         
-        //*********************************
-        //***STEP 3: READ IN PARENT DIRECTORY STUFF
-        //  Set global variables that holds current directories inode & block
-        currentDirectoryInode = changeToParentDirectoryInode;
-        curDirBlock = changeToParentDirectoryCurDirBlock;
-
-        gettimeofday( &( inode[currentDirectoryInode].lastAccess ), NULL );
-        
-        //  Read / open the directory that you are entering information
-        disk_read( changeToParentDirectoryCurDirBlock, ( char* )&curDir );
+        inode_lock( fs, parent, 0 );
+        inode_touch( fs, parent );
+        inode_unlock( fs, parent );
+        pthread_rwlock_unlock( &fs->volumeLock );
     }
     else //ELSE: Use the name passed in to find directory's inode number
     {
         //  Gets directories Inode
-        int changeToDirectoryInode = search_cur_dir( name );
+        pthread_rwlock_wrlock( &fs->volumeLock );
+        int changeToDirectoryInode = path_lookup( fs, name, 0 );
         
         //  ERROR CHECK: making sure directory exist
         if( changeToDirectoryInode < 0 )
         {
             printf( "Change directory error: file is not exist.\n" );
+            pthread_rwlock_unlock( &fs->volumeLock );
             
             return -1;
         }
         
-        // Sets global variable that holds inode of current directory
-        currentDirectoryInode = changeToDirectoryInode;
-        
         //Checks to see if it is of type directory
-        if( inode[changeToDirectoryInode].type == directory ) //IF: type directory, enter
+        if( fs->inode[changeToDirectoryInode].type == directory ) //IF: type directory, enter
         {
-            //  Get this directories inode to changeToDirectoryCurDirBlock
-            int changeToDirectoryCurDirBlock = inode[changeToDirectoryInode].directBlock[0];
-
-            //  Get this directories parent inode to changeFromDirectoryInode
-
-            //  Get this directories parent curDirBlock
-            int changeFromDirectoryCurDirBlock = inode[search_cur_dir(".")].directBlock[0];
-            
-            //*********************************
-            //***STEP 1: Write new files / information to disk
-            //  Write the files / data into disk for this directory
-            disk_write( changeFromDirectoryCurDirBlock, ( char* )&curDir );
+            // Sets global variable that holds inode of current directory
+            fs->currentDirectoryInode = changeToDirectoryInode;
             
-            
-            //*********************************
-            //***STEP 2: READ NEW DIRECTORY INFORMATION FROM DISK
-            //  Set global variable that holds current directory's block
-            curDirBlock = changeToDirectoryCurDirBlock;
-
-            gettimeofday( &( inode[changeToDirectoryInode].lastAccess ), NULL );
-            //  Read / open the directory that you are entering information
-            disk_read( changeToDirectoryCurDirBlock, ( char* )&curDir );
+            inode_touch( fs, changeToDirectoryInode );
+            inode_unlock( fs, changeToDirectoryInode );
+            pthread_rwlock_unlock( &fs->volumeLock );
         }
         else //ELSE: File return
         {
             printf( "Change directory error: Type is file, not directory\n" );
+            inode_unlock( fs, changeToDirectoryInode );
+            pthread_rwlock_unlock( &fs->volumeLock );
             
             return -1;
         }
@@ -1286,40 +2927,116 @@ int dir_change( char * name )
 
 
 /**
- * Method: Provided by the Professor; Modifed the for loop.
+ * Method: Prints one line of ls
  *
- * @param: None
+ * @param: fs_t * fs - the volume
+ * @param: char * name - the entry's name
+ * @param: int n - the entry's inode
+ *
+ * Return: None
+ */
+void ls_entry( fs_t * fs, char * name, int n )
+{
+    if( fs->inode[n].type == file ) //IF: type is file
+    {
+        printf( "type: file, " );
+    }
+    else //ELSE: type is directory
+    {
+        printf( "type: dir, " );
+    }
+    
+    printf( "name \"%s\", inode %d, size %d byte\n", name, n, fs->inode[n].size );
+}
+
+
+
+/**
+ * Method: Provided by the Professor; Modifed the for loop. Lists a
+ *  directory, or prints the one entry of a file
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char * path - the directory or file, "." for the current
+ *      directory
  *
  * Return: int
  */
-int ls()
+int ls( fs_t * fs, char * path )
 {
     //---VARIABLE(S)---
     //  integer(s)
     int i;
+    int j;
+    int block;
+    int numLeaf;
+    int * leaves;
+    int dirInode;
+    //  char(s)
+    char name[MAX_FILE_NAME];
+    //  Dentry *(s)
+    Dentry * leaf;
+    
+    pthread_rwlock_rdlock( &fs->volumeLock );
     
-    //  Loop through the # of MAX_DIR_ENTRY
-    for( i = 0; i < MAX_DIR_ENTRY; i++ )
+    if( path_parent( fs, path, &dirInode, name ) < 0 )
     {
-        //  Assign the inode to n
-        int n = curDir.dentry[i].inode;
+        printf( "ls error: %s does not exist.\n", path );
+        pthread_rwlock_unlock( &fs->volumeLock );
         
-        //IF: Enter the loop if size doesn't equal one / name isn't blank
-        if(( inode[n].size != 1 ) || ( strcmp( curDir.dentry[i].name, "" ) != 0  ))
+        return -1;
+    }
+    
+    inode_lock( fs, dirInode, 0 );
+    
+    if(( i = dir_lookup( fs, dirInode, name )) < 0 || fs->inode[i].type == file )
+    {
+        if( i < 0 )
         {
-            if( inode[n].type == file ) //IF: type is file
-            {
-                printf( "type: file, " );
-            }
-            else //ELSE: type is directory
+            printf( "ls error: %s does not exist.\n", path );
+        }
+        else //ELSE: A file lists as itself
+        {
+            ls_entry( fs, name, i );
+        }
+        
+        inode_unlock( fs, dirInode );
+        pthread_rwlock_unlock( &fs->volumeLock );
+        
+        return i < 0 ? -1 : 0;
+    }
+    
+    //  Only the directory being listed stays locked
+    inode_unlock( fs, dirInode );
+    dirInode = i;
+    inode_lock( fs, dirInode, 0 );
+    numLeaf = dir_leaves( fs, dirInode, &leaves );
+    
+    //  Loop through every leaf of the directory, then its entries
+    for( j = 0; j < numLeaf; j++ )
+    {
+        block = dir_block( fs, dirInode, leaves[j] );
+        
+        if( block == 0 || ( leaf = ( Dentry * ) cache_get( &fs->cache, block )) == NULL )
+        {
+            continue;
+        }
+        
+        for( i = 0; i < MAX_DIR_ENTRY; i++ )
+        {
+            //IF: Enter the loop if the name isn't blank
+            if( strcmp( leaf->dentry[i].name, "" ) != 0 )
             {
-                printf( "type: dir, " );
+                ls_entry( fs, leaf->dentry[i].name, leaf->dentry[i].inode );
             }
-            
-            printf( "name \"%s\", inode %d, size %d byte\n", curDir.dentry[i].name, curDir.dentry[i].inode, inode[n].size );
         }
+        
+        cache_release( &fs->cache, block, 0 );
     }
     
+    inode_unlock( fs, dirInode );
+    pthread_rwlock_unlock( &fs->volumeLock );
+    free( leaves );
+    
     return 0;
 }
 
@@ -1328,14 +3045,22 @@ int ls()
 /**
  * Method: Provided by the Professor; Provides the stats of the file/directory
  *
- * @param: None
+ * @param: fs_t * fs - the volume
  *
  * Return: int
  */
-int fs_stat()
+int fs_stat( fs_t * fs )
 {
+    //---VARIABLE(S)---
+    //  int(s)
+    int freeBlocks = __atomic_load_n( &fs->superBlock.freeBlockCount, __ATOMIC_RELAXED );
+    int freeInodes = __atomic_load_n( &fs->superBlock.freeInodeCount, __ATOMIC_RELAXED );
+    
     printf( "File System Status: \n" );
-    printf( "# of free blocks: %d (%d bytes), # of free inodes: %d\n", superBlock.freeBlockCount, superBlock.freeBlockCount * 512, superBlock.freeInodeCount );
+    printf( "# of free blocks: %d (%lld bytes), # of free inodes: %d\n", freeBlocks, ( long long ) freeBlocks * fs->superBlock.blockSize, freeInodes );
+    extent_stat( fs );
+    cache_stat( &fs->cache );
+    dcache_stat( fs );
     
     return 0;
 }
@@ -1343,128 +3068,139 @@ int fs_stat()
 
 
 /**
- * Method: Provided by the Professor; Ensures the entered prompts are correct
+ * Method: Fills commandSlot from commandTable; run once
  *
- * @param: char *comm | @param: char *arg1 | @param char *arg2 | @param char *arg3
- * @param: char *arg3 | @param: char *arg4 | @param int numArg
+ * @param: None
  *
- * Return: int
+ * Return: None
  */
-int execute_command( char * comm, char * arg1, char * arg2, char * arg3, char * arg4, int numArg )
+void command_index()
 {
-    if( command( comm, "create" ))
-    {
-        if( numArg < 2 )
-        {
-            printf( "Error: create <filename> <size>\n" );
-            
-            return -1;
-        }
-        
-        return file_create( arg1, atoi( arg2 )); // (filename, size)
-    }
-    else if( command( comm, "cat" ))
-    {
-        if( numArg < 1 )
-        {
-            printf( "Error: cat <filename>\n" );
-            
-            return -1;
-        }
-        
-        return file_cat( arg1 ); // file_cat(filename)
-    }
-    else if( command( comm, "write" ))
-    {
-        if(numArg < 4)
-        {
-            printf( "Error: write <filename> <offset> <size> <buf>\n" );
-            
-            return -1;
-        }
-        
-        return file_write( arg1, atoi( arg2 ), atoi( arg3 ), arg4 ); // file_write(filename, offset, size, buf);
-    }
-    else if( command( comm, "read" ))
-    {
-        if( numArg < 3 )
-        {
-            printf( "Error: read <filename> <offset> <size>\n" );
-            
-            return -1;
-        }
-        
-        return file_read( arg1, atoi( arg2 ), atoi( arg3 )); // file_read(filename, offset, size);
-    }
-    else if( command( comm, "rm" ))
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    unsigned int slot;
+    
+    for( i = 0; i < NUM_COMMAND; i++ )
     {
-        if( numArg < 1 )
-        {
-            printf( "Error: rm <filename>\n" );
-            
-            return -1;
-        }
+        slot = dir_hash( commandTable[i].name ) & ( COMMAND_SLOT - 1 );
         
-        return file_remove( arg1 ); //(filename)
-    }
-    else if( command( comm, "mkdir" ))
-    {
-        if( numArg < 1 )
+        while( commandSlot[slot] != 0 )
         {
-            printf( "Error: mkdir <dirname>\n" );
-            
-            return -1;
+            slot = ( slot + 1 ) & ( COMMAND_SLOT - 1 );
         }
         
-        return dir_make( arg1 ); // (dirname)
+        commandSlot[slot] = i + 1;
     }
-    else if(command(comm, "rmdir"))
+}
+
+
+
+/**
+ * Method: Finds a command by name with one hash and, nearly always,
+ *  one string compare
+ *
+ * @param: char * comm - the name
+ *
+ * Return: int - the COMMAND or -1
+ */
+int command_find( char * comm )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    unsigned int slot = dir_hash( comm ) & ( COMMAND_SLOT - 1 );
+    
+    pthread_once( &commandOnce, command_index );
+    
+    while( commandSlot[slot] != 0 )
     {
-        if(numArg < 1)
+        if( strcmp( commandTable[commandSlot[slot] - 1].name, comm ) == 0 )
         {
-            printf("Error: rmdir <dirname>\n");
-            
-            return -1;
+            return commandSlot[slot] - 1;
         }
         
-        return dir_remove( arg1 ); // (dirname)
+        slot = ( slot + 1 ) & ( COMMAND_SLOT - 1 );
     }
-    else if( command( comm, "cd" ))
+    
+    return -1;
+}
+
+
+
+/**
+ * Method: Provided by the Professor; Ensures the entered prompts are
+ *  correct. The command is found through a hash of its name rather
+ *  than by comparing it with each name in turn
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char *comm | @param: char *arg1 | @param char *arg2 | @param char *arg3
+ * @param: char *arg3 | @param: char *arg4 | @param int numArg
+ * @param: FILE * in - the stream the command was read from, which
+ *      writein reads its payload from
+ *
+ * Return: int
+ */
+int execute_command( fs_t * fs, char * comm, char * arg1, char * arg2, char * arg3, char * arg4, int numArg, FILE * in )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int cmd = command_find( comm );
+    
+    if( cmd < 0 )
     {
-        if( numArg < 1 )
-        {
-            printf( "Error: cd <dirname>\n" );
-            
-            return -1;
-        }
+        fprintf( stderr, "%s: command not found.\n", comm );
         
-        return dir_change( arg1 ); // (dirname)
-    }
-    else if( command( comm, "ls" ))
-    {
-        return ls();
+        return -1;
     }
-    else if( command( comm, "stat" ))
+    
+    if( numArg < commandTable[cmd].minArg )
     {
-        if( numArg < 1 )
-        {
-            printf( "Error: stat <filename>\n" );
-            
-            return -1;
-        }
+        printf( "Error: %s\n", commandTable[cmd].usage );
         
-        return file_stat( arg1 ); //(filename)
-    }
-    else if( command( comm, "df" ))
-    {
-        return fs_stat();
+        return -1;
     }
-    else
+    
+    switch( cmd )
     {
-        fprintf( stderr, "%s: command not found.\n", comm );
-        
-        return -1;
+        case CMD_CREATE:
+            return file_create( fs, arg1, atoi( arg2 )); // (filename, size)
+        case CMD_CAT:
+            return file_cat( fs, arg1 ); // file_cat(filename)
+        case CMD_WRITE:
+            return file_write( fs, arg1, atoi( arg2 ), atoi( arg3 ), arg4 ); // file_write(filename, offset, size, buf);
+        case CMD_READ:
+            return file_read( fs, arg1, atoi( arg2 ), atoi( arg3 )); // file_read(filename, offset, size);
+        case CMD_RM:
+            return file_remove( fs, arg1 ); //(filename)
+        case CMD_MKDIR:
+            return dir_make( fs, arg1 ); // (dirname)
+        case CMD_RMDIR:
+            return dir_remove( fs, arg1 ); // (dirname)
+        case CMD_CD:
+            return dir_change( fs, arg1 ); // (dirname)
+        case CMD_LS:
+            return ls( fs, numArg < 1 ? "." : arg1 ); // (path), the current directory without one
+        case CMD_STAT:
+            return file_stat( fs, arg1 ); //(filename)
+        case CMD_DF:
+            return fs_stat( fs );
+        case CMD_SYNC:
+            return fs_sync( fs );
+        case CMD_OPEN:
+            return file_open( fs, arg1 ) < 0 ? -1 : 0; // (filename), prints the descriptor
+        case CMD_CLOSE:
+            return file_close( fs, atoi( arg1 )); // (fd)
+        case CMD_SEEK:
+            return file_seek( fs, atoi( arg1 ), atoi( arg2 )); // (fd, offset)
+        case CMD_PREAD:
+            return file_pread( fs, atoi( arg1 ), atoi( arg2 ), atoi( arg3 )); // (fd, offset, size)
+        case CMD_PWRITE:
+            return file_pwrite( fs, atoi( arg1 ), atoi( arg2 ), atoi( arg3 ), arg4 ); // (fd, offset, size, buf)
+        case CMD_WRITEIN:
+            return file_write_in( fs, arg1, atoi( arg2 ), atoll( arg3 ), in ); // (filename, offset, size), the bytes follow
+        case CMD_WRITEFROM:
+            return file_write_host( fs, arg1, atoi( arg2 ), arg3 ); // (filename, offset, host file)
     }
     
     return 0;
-}
\ No newline at end of file
+}
@@ -8,30 +8,87 @@
  *      directory and inode structures.
  *********************************************************/
 
+#ifndef FS_H
+#define FS_H
+
 //---IMPORT(S)---
+#include <stdio.h>
+#include <stdint.h>
 #include <sys/time.h>
+#include <pthread.h>
 #include "disk.h"
+#include "cache.h"
 
 //---DEFINITION(S)---
-#define MAX_BLOCK 4096
-#define MAX_INODE 512
+#define FS_MAGIC 0x46533034
+#define DEFAULT_BLOCK_SIZE 512
+#define DEFAULT_MAX_BLOCK 4096
+#define DEFAULT_MAX_INODE 512
+#define DIRECT_BLOCK 10
 #define SMALL_FILE 5120
-#define LARGE_FILE 70656
+#define LARGE_FILE 70656 // direct plus single indirect blocks at 512 bytes
 #define MAX_FILE_NAME 16
-#define MAX_DIR_ENTRY BLOCK_SIZE / sizeof( DirectoryEntry )
+#define MAX_PATH 256
+#define MAX_DIR_ENTRY (( int )( MIN_BLOCK_SIZE / sizeof( DirectoryEntry )))
+#define SUMMARY_LEVEL 6
+#define INODE_EXTENT 4
+#define INODE_EXTENTS 0x1
+#define INODE_INLINE 0x2
+#define INODE_HTREE 0x4
+#define INLINE_DATA 56
+#define READAHEAD_MIN 4
+#define READAHEAD_MAX 64
+#define OPEN_FILE 64
+#define COMMAND_SLOT 64
 
 
 typedef enum {file, directory} TYPE;
 
-//Super Block data structure
+//The shell's commands, in the order of commandTable in fs.c
+typedef enum {CMD_CREATE, CMD_CAT, CMD_WRITE, CMD_READ, CMD_RM, CMD_MKDIR, CMD_RMDIR, CMD_CD, CMD_LS, CMD_STAT,
+              CMD_DF, CMD_SYNC, CMD_OPEN, CMD_CLOSE, CMD_SEEK, CMD_PREAD, CMD_PWRITE, CMD_WRITEIN, CMD_WRITEFROM, NUM_COMMAND} COMMAND;
+
+//A shell command's name, how many arguments it needs and the usage
+//  printed when it gets fewer
+typedef struct
+{
+        char * name;
+        int minArg;
+        char * usage;
+} Command;
+
+//Super Block data structure; images without FS_MAGIC predate the
+//  geometry fields and are read as 512 byte blocks, 4096 blocks, 512 inodes
 typedef struct
 {
 		int freeBlockCount;
 		int freeInodeCount;
-		char padding[504];
+		int magic;
+		int blockSize;
+		int blockCount;
+		int inodeCount;
+		int inodeMapStart;
+		int blockMapStart;
+		int inodeTableStart;
+		int dataStart;
+		int nextFreeInode;
+		int nextFreeBlock;
+		char padding[464];
 } SuperBlock;
 
-//iNode Information
+//A run of a file's blocks: length blocks starting at logical block
+//  logical are stored at physical block physical onwards
+typedef struct
+{
+        int logical;
+        int physical;
+        int length;
+} Extent;
+
+//iNode Information; INODE_EXTENTS in flags selects the extent map
+//  over the block pointers, INODE_INLINE keeps a file of up to
+//  INLINE_DATA bytes in the inode itself and INODE_HTREE marks a
+//  directory whose blocks are found through a hash index
 typedef struct
 {
 		TYPE type;
@@ -41,9 +98,24 @@ typedef struct
         int group;
 		int size;
 		int blockCount;
-		int indirectBlock;
-        int directBlock[10];
-		char padding[24];
+		union
+		{
+			struct
+			{
+				int indirectBlock;
+				int directBlock[DIRECT_BLOCK];
+				int doubleIndirectBlock;
+			};
+			struct
+			{
+				Extent extent[INODE_EXTENT];
+				int extentCount;
+				int extentTree;
+			};
+			char inlineData[INLINE_DATA];
+		};
+		int flags;
+		char padding[8];
 } Inode; // 128 bytes
 
 //Each directory entry
@@ -53,23 +125,125 @@ typedef struct
 		char name[MAX_FILE_NAME];
 } DirectoryEntry;
 
-//Entire dicrectory - One data block
+//One leaf block of a directory; only the first MIN_BLOCK_SIZE
+//  bytes of a larger block are used. Unused slots form a free list
+//  that starts at slot freeSlot - 1
 typedef struct
 {
         DirectoryEntry dentry[MAX_DIR_ENTRY];
 		int numEntry;
-		char padding[8];
+		int freeSlot;
+		char padding[4];
 } Dentry;
 
-//---GLOBAL VARIABLE(S)---
-//CHAR(S)
-extern char inodeMap[MAX_INODE / 8];
-extern char blockMap[MAX_BLOCK / 8];
-//STRUCT(S)
-extern SuperBlock superBlock;
+//A run of free data blocks; kept in memory only, rebuilt from the
+//  block map at mount
+typedef struct
+{
+        int start;
+        int length;
+} FreeExtent;
+
+//Access pattern of one file's reads, kept in memory only: a read that
+//  starts at next continues a sequential scan, whose blocks up to
+//  ahead are already being read in windows of window blocks. Readers
+//  share the inode lock, so lock covers these and the inode's lastAccess
+typedef struct
+{
+        pthread_mutex_t lock;
+        int next;
+        int window;
+        int ahead;
+} Readahead;
+
+//An open file: its inode, resolved once by file_open so reads and
+//  writes through the descriptor skip the path walk, and the offset
+//  the next read or write without one starts at
+typedef struct
+{
+        int used;
+        int inodeNum;
+        int offset;
+} OpenFile;
+
+//Summary levels over a bitmap, kept in memory only; bit i of level 0 is
+//  set when 64 bit word i of the map is full and bit i of level n when
+//  word i of level n - 1 is full. The top level is a single word
+typedef struct
+{
+        char * map;
+        int count;
+        int levels;
+        int numWord[SUMMARY_LEVEL];
+        uint64_t * full[SUMMARY_LEVEL];
+} BitSummary;
+
+//Every mounted volume has one of these; nothing of a volume's state
+//  lives outside it, so one process can serve several images. Each
+//  command holds volumeLock shared and the inodes it uses through
+//  inodeLock, a directory before its entries; rmdir and sync hold
+//  volumeLock alone. The other locks guard the shared tables below
+typedef struct fs_t fs_t;
+
+//The modules' state types need the ones above
+#include "bmap.h"
+#include "dir.h"
+#include "dcache.h"
+
+struct fs_t
+{
+        disk_t disk;
+        cache_t cache;
+        pthread_rwlock_t volumeLock;
+        pthread_rwlock_t * inodeLock;
+        SuperBlock superBlock;
+        Inode * inode;
+        Readahead * readahead;
+        char * inodeMap;
+        char * blockMap;
+        char * metaDirty;
+        int currentDirectoryInode;
+        //  Descriptors from file_open
+        pthread_mutex_t openLock;
+        OpenFile openFile[OPEN_FILE];
+        int formatBlockSize;
+        int formatBlockCount;
+        int formatInodeCount;
+        //  Free space, see fs_util.c
+        pthread_mutex_t allocLock;
+        int reservedBlocks;
+        FreeExtent * freeExtents;
+        int numFreeExtents;
+        int maxFreeExtents;
+        BitSummary inodeSummary;
+        BitSummary blockSummary;
+        //  Block lists of pointer mapped files, see bmap.c
+        pthread_mutex_t xlatLock;
+        Xlat xlat[XLAT_ENTRY];
+        int xlatClock;
+        int xlatGen;
+        //  Directory leaves and names, see dir.c and dcache.c
+        DirView dirView[DIR_VIEW];
+        pthread_rwlock_t dcacheLock;
+        DcacheEntry dcache[DCACHE_ENTRY];
+        long long dcacheHits;
+        long long dcacheMisses;
+        char structBuf[MAX_BLOCK_SIZE];
+};
 
 //---METHOD INSTANTIATION(S)---
-int fs_mount( char * name );
-int fs_umount( char * name );
-int dir_change( char * name );
-int execute_command( char * comm, char * arg1, char * arg2, char * arg3, char * arg4, int numArg );
\ No newline at end of file
+fs_t * fs_new();
+void fs_free( fs_t * fs );
+int fs_set_geometry( fs_t * fs, int blockSize, int blockCount, int inodeCount );
+int fs_mount( fs_t * fs, char * name );
+int fs_umount( fs_t * fs );
+int fs_sync( fs_t * fs );
+int dir_change( fs_t * fs, char * name );
+int file_open( fs_t * fs, char * path );
+int file_close( fs_t * fs, int fd );
+int file_seek( fs_t * fs, int fd, int offset );
+int file_pread( fs_t * fs, int fd, int offset, int size );
+int file_pwrite( fs_t * fs, int fd, int offset, int size, char * buf );
+int execute_command( fs_t * fs, char * comm, char * arg1, char * arg2, char * arg3, char * arg4, int numArg, FILE * in );
+
+#endif
@@ -10,11 +10,15 @@
 
 //---IMPORT(S)---
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include <stdbool.h>
+#include <fcntl.h>
 #include "fs.h"
 #include "disk.h"
+#include "cache.h"
 
 
 
@@ -28,57 +32,300 @@ bool command(char * comm, char * comm2)
     return false;
 }
 
-int main(int argc, char ** argv)
+
+
+/**
+ * Method: Splits a line into words in place: the blanks after each word
+ *  are overwritten with NULs and word points into the line, so nothing
+ *  is copied or cleared. Words past max are left out; missing ones
+ *  point at an empty string
+ *
+ * @param: char * line - the line, changed
+ * @param: char ** word - set to the words
+ * @param: int max - how many words word holds
+ *
+ * Return: int - the number of words found
+ */
+int split_line( char * line, char ** word, int max )
 {
     //---VARIABLE(S)---
-    //  char(s)
-    char comm[64];
-    char arg1[16];
-    char arg2[16];
-    char arg3[16];
-    char arg4[LARGE_FILE];
-    char input[64 + 16 + 16 + 16 + LARGE_FILE];
+    //  int(s)
+    int count = 0;
+    int i;
     
-    srand( time( NULL ));
+    while( count < max )
+    {
+        while( *line == ' ' || *line == '\t' || *line == '\n' || *line == '\r' )
+        {
+            line++;
+        }
+        
+        if( *line == '\0' )
+        {
+            break;
+        }
+        
+        word[count++] = line;
+        
+        while( *line != '\0' && *line != ' ' && *line != '\t' && *line != '\n' && *line != '\r' )
+        {
+            line++;
+        }
+        
+        if( *line != '\0' )
+        {
+            *line++ = '\0';
+        }
+    }
     
-    if( argc < 2 )
+    for( i = count; i < max; i++ )
     {
-        fprintf( stderr, "usage: ./fs disk_name\n" );
+        word[i] = "";
+    }
+    
+    return count;
+}
+
+
+
+/**
+ * Method: Runs the commands of a script, "-" for standard input,
+ *  without prompts. What the commands print is thrown away; at the
+ *  end the number of commands, how many failed and the time they took
+ *  are printed. Blank lines and lines starting with '#' are skipped
+ *
+ * @param: fs_t * fs - the volume
+ * @param: char * script - the script's path
+ * @param: char * input - a line buffer
+ * @param: int size - the size of input
+ *
+ * Return: int
+ */
+int run_batch( fs_t * fs, char * script, char * input, int size )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int out;
+    int null;
+    int numWord;
+    long long count = 0;
+    long long failed = 0;
+    //  double(s)
+    double seconds;
+    //  char *(s)
+    char * word[5];
+    //  FILE *(s)
+    FILE * in = command( script, "-" ) ? stdin : fopen( script, "r" );
+    //  timespec(s)
+    struct timespec start;
+    struct timespec end;
+    
+    if( in == NULL )
+    {
+        fprintf( stderr, "fs_sim: could not open %s\n", script );
         
         return -1;
     }
-    srand( time( NULL ));
     
-    //Call to fs.c file - which will pass file to disk.c to mount
-    fs_mount( argv[1] );
+    //  Commands print to the descriptor as well as through stdio, so
+    //  the descriptor itself goes to /dev/null
+    fflush( stdout );
+    out = dup( STDOUT_FILENO );
+    null = open( "/dev/null", O_WRONLY );
     
-    //Prints the standard prompt for input
-    printf( "%% " );
+    if( out < 0 || null < 0 || dup2( null, STDOUT_FILENO ) < 0 )
+    {
+        fprintf( stderr, "fs_sim: could not silence the output\n" );
+        
+        if( out >= 0 )
+        {
+            close( out );
+        }
+        
+        if( null >= 0 )
+        {
+            close( null );
+        }
+        
+        if( in != stdin )
+        {
+            fclose( in );
+        }
+        
+        return -1;
+    }
     
-    //The main while loop that will keep the simulator running until
-    //  'quit' or 'exit' called
-    while( fgets( input, ( MAX_FILE_NAME + SMALL_FILE ), stdin ))
+    close( null );
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    
+    while( fgets( input, size, in ))
     {
-        bzero( comm, 64 );
-        bzero( arg1, 16 );
-        bzero( arg2, 16 );
-        bzero( arg3, 16 );
-        bzero( arg4, LARGE_FILE );
+        numWord = split_line( input, word, 5 );
         
-        int numArg = sscanf( input, "%s %s %s %s %s", comm, arg1, arg2, arg3, arg4 );
+        if( numWord == 0 || word[0][0] == '#' )
+        {
+            continue;
+        }
         
-        if( command( comm, "quit" ) || command( comm, "exit" ))
+        if( command( word[0], "quit" ) || command( word[0], "exit" ))
         {
             break;
         }
+        
+        count++;
+        
+        if( execute_command( fs, word[0], word[1], word[2], word[3], word[4], numWord - 1, in ) < 0 )
+        {
+            failed++;
+        }
+    }
+    
+    clock_gettime( CLOCK_MONOTONIC, &end );
+    fflush( stdout );
+    dup2( out, STDOUT_FILENO );
+    close( out );
+    
+    if( in != stdin )
+    {
+        fclose( in );
+    }
+    
+    seconds = ( end.tv_sec - start.tv_sec ) + ( end.tv_nsec - start.tv_nsec ) / 1e9;
+    printf( "Batch: %lld commands, %lld failed, %.3f s, %.0f commands/s\n",
+            count, failed, seconds, seconds > 0 ? count / seconds : 0.0 );
+    
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    //---VARIABLE(S)---
+    //  char(s)
+    char input[64 + MAX_PATH + 16 + 16 + LARGE_FILE];
+    //  char *(s)
+    char * word[5];
+    char * script = NULL;
+    //  int(s)
+    int opt;
+    int numWord;
+    int blockSize = DEFAULT_BLOCK_SIZE;
+    int blockCount = DEFAULT_MAX_BLOCK;
+    int inodeCount = DEFAULT_MAX_INODE;
+    //  fs_t *(s)
+    fs_t * fs = fs_new();
+    
+    if( fs == NULL )
+    {
+        return -1;
+    }
+    
+    srand( time( NULL ));
+    
+    //  Options come before the disk name
+    while(( opt = getopt( argc, argv, "m:b:n:i:c:s:" )) != -1 )
+    {
+        if( opt == 'm' && command( optarg, "memory" ))
+        {
+            disk_set_backend( &fs->disk, DISK_MEMORY );
+        }
+        else if( opt == 'm' && command( optarg, "mmap" ))
+        {
+            disk_set_backend( &fs->disk, DISK_MMAP );
+        }
+        else if( opt == 'm' && command( optarg, "pio" ))
+        {
+            disk_set_backend( &fs->disk, DISK_PIO );
+        }
+        else if( opt == 'm' && command( optarg, "direct" ))
+        {
+            disk_set_backend( &fs->disk, DISK_DIRECT );
+        }
+        else if( opt == 'b' )
+        {
+            blockSize = atoi( optarg );
+        }
+        else if( opt == 'n' )
+        {
+            blockCount = atoi( optarg );
+        }
+        else if( opt == 'i' )
+        {
+            inodeCount = atoi( optarg );
+        }
+        else if( opt == 's' )
+        {
+            script = optarg;
+        }
+        else if( opt == 'c' )
+        {
+            if( cache_set_size( &fs->cache, atoi( optarg )) < 0 )
+            {
+                return -1;
+            }
+        }
         else
         {
-            execute_command(comm, arg1, arg2, arg3, arg4, numArg - 1);
+            optind = argc;
+            
+            break;
         }
+    }
+    
+    if( optind != argc - 1 )
+    {
+        fprintf( stderr, "usage: ./fs [-m memory|mmap|pio|direct] [-b block_size] [-n blocks] [-i inodes] [-c cache_blocks] [-s script|-] disk_name\n" );
         
-        printf("%% ");
+        return -1;
+    }
+    
+    //  Only used when the disk does not exist yet and has to be formatted
+    if( fs_set_geometry( fs, blockSize, blockCount, inodeCount ) < 0 )
+    {
+        return -1;
+    }
+    
+    //Call to fs.c file - which will pass file to disk.c to mount
+    if( fs_mount( fs, argv[optind] ) < 0 )
+    {
+        return -1;
+    }
+    
+    if( script != NULL ) //IF: A script runs without prompts or output
+    {
+        run_batch( fs, script, input, sizeof( input ));
+    }
+    else
+    {
+        //Prints the standard prompt for input
+        printf( "%% " );
+        
+        //The main while loop that will keep the simulator running until
+        //  'quit' or 'exit' called
+        while( fgets( input, ( MAX_FILE_NAME + SMALL_FILE ), stdin ))
+        {
+            numWord = split_line( input, word, 5 );
+            
+            if( numWord == 0 ) //IF: Blank line, just prompt again
+            {
+                printf( "%% " );
+                
+                continue;
+            }
+            
+            if( command( word[0], "quit" ) || command( word[0], "exit" ))
+            {
+                break;
+            }
+            else
+            {
+                execute_command( fs, word[0], word[1], word[2], word[3], word[4], numWord - 1, stdin );
+            }
+            
+            printf("%% ");
+        }
     }
     
     //Call to fs.c file - which will pass file to disk.c to unmount
-    fs_umount(argv[1]);
+    fs_umount( fs );
+    fs_free( fs );
 }
\ No newline at end of file
@@ -11,10 +11,16 @@
 //---IMPORT(S)---
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <time.h>
+#include <pthread.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "fs.h"
-
-
+#include "fs_util.h"
+#include "cache.h"
 
 /**
  * Method: Creates random number of chars for string
@@ -106,61 +112,1149 @@ void set_bit( char * array, int index, char value )
 
 
 
-/*
- * Method: Checks for a free inode and then returns it if
- *  there is one
+/**
+ * Method: Loads 64 bits of a bitmap so that bit n of the word is
+ *  bit ( word * 64 + n ) of the map, matching get_bit
  *
- * PARAMETERS: None
+ * @param: char * array - the bitmap
+ * @param: int word - the index of the 64 bit word
  *
- * Returns: int
+ * Returns: uint64_t
+ */
+uint64_t load_word( char * array, int word )
+{
+    uint64_t value;
+    
+    memcpy( &value, array + ( size_t ) word * 8, 8 );
+    
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64( value );
+#endif
+    
+    return value;
+}
+
+
+
+/**
+ * Method: Skips words that are completely set, 16 bytes at a time
+ *  with SSE2 when it is available
+ *
+ * @param: char * array - the bitmap
+ * @param: int word - the first word to look at
+ * @param: int numWord - the number of words in the map
+ *
+ * Returns: int - the first word at or after word that has a zero bit,
+ *      or numWord if there is none
+ */
+int skip_full_words( char * array, int word, int numWord )
+{
+#ifdef __SSE2__
+    __m128i ones = _mm_set1_epi8( -1 );
+    
+    while( word + 2 <= numWord )
+    {
+        __m128i chunk = _mm_loadu_si128(( __m128i * )( array + ( size_t ) word * 8 ));
+        
+        if( _mm_movemask_epi8( _mm_cmpeq_epi8( chunk, ones )) != 0xFFFF )
+        {
+            break;
+        }
+        
+        word += 2;
+    }
+#endif
+    
+    while( word < numWord && load_word( array, word ) == UINT64_MAX )
+    {
+        word++;
+    }
+    
+    return word;
+}
+
+
+
+/**
+ * Method: Finds the first clear bit in [start, end) of a bitmap a
+ *  word at a time, using count-trailing-zeros inside a word
+ *
+ * @param: char * array - the bitmap, padded out to whole words
+ * @param: int start - the first bit to look at
+ * @param: int end - one past the last bit to look at
+ *
+ * Returns: int - the bit index or -1 if every bit is set
+ */
+int find_clear_bit( char * array, int start, int end )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int word = start / 64;
+    int numWord = ( end + 63 ) / 64;
+    int index;
+    //  uint64_t(s)
+    uint64_t free;
+    
+    if( start >= end )
+    {
+        return -1;
+    }
+    
+    //  Ignore the bits below start in the first word
+    free = ~load_word( array, word ) & ( UINT64_MAX << ( start % 64 ));
+    
+    while( free == 0 )
+    {
+        word = skip_full_words( array, word + 1, numWord );
+        
+        if( word >= numWord )
+        {
+            return -1;
+        }
+        
+        free = ~load_word( array, word );
+    }
+    
+    index = word * 64 + __builtin_ctzll( free );
+    
+    return ( index < end ) ? index : -1;
+}
+
+
+
+/**
+ * Method: Finds the first set bit in [start, end) of a bitmap a
+ *  word at a time
+ *
+ * @param: char * array - the bitmap, padded out to whole words
+ * @param: int start - the first bit to look at
+ * @param: int end - one past the last bit to look at
+ *
+ * Returns: int - the bit index or end if every bit is clear
+ */
+int find_set_bit( char * array, int start, int end )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int word = start / 64;
+    int numWord = ( end + 63 ) / 64;
+    int index;
+    //  uint64_t(s)
+    uint64_t used;
+    
+    if( start >= end )
+    {
+        return end;
+    }
+    
+    used = load_word( array, word ) & ( UINT64_MAX << ( start % 64 ));
+    
+    while( used == 0 )
+    {
+        if( ++word >= numWord )
+        {
+            return end;
+        }
+    
+        used = load_word( array, word );
+    }
+    
+    index = word * 64 + __builtin_ctzll( used );
+    
+    return ( index < end ) ? index : end;
+}
+
+
+
+/**
+ * Method: Loads a word of the map with the bits past the end of the
+ *  map set, so the padding never looks free
+ *
+ * @param: BitSummary * summary - the map and its summary
+ * @param: int word - the index of the 64 bit word
+ *
+ * Returns: uint64_t
+ */
+uint64_t summary_map_word( BitSummary * summary, int word )
+{
+    uint64_t value = load_word( summary->map, word );
+    
+    if( word == ( summary->count - 1 ) / 64 && summary->count % 64 != 0 )
+    {
+        value |= UINT64_MAX << ( summary->count % 64 );
+    }
+    
+    return value;
+}
+
+
+
+/**
+ * Method: Sets or clears bit index of a summary level and reports
+ *  whether the word holding it is now full
+ *
+ * @param: uint64_t * level - the summary level
+ * @param: int index - the bit to change
+ * @param: int value - 1 when the child is full
+ *
+ * Returns: int - 1 if the word is full
+ */
+int summary_mark( uint64_t * level, int index, int value )
+{
+    if( value )
+    {
+        level[index / 64] |= ( uint64_t ) 1 << ( index % 64 );
+    }
+    else
+    {
+        level[index / 64] &= ~(( uint64_t ) 1 << ( index % 64 ));
+    }
+    
+    return level[index / 64] == UINT64_MAX;
+}
+
+
+
+/**
+ * Method: Builds the summary levels over a bitmap; bits past the last
+ *  child of each level start out set so they are never chosen
  *
+ * @param: BitSummary * summary - the summary to build
+ * @param: char * map - the bitmap
+ * @param: int count - the number of bits in the map
+ *
+ * Returns: int
  */
-int get_free_inode()
+int summary_build( BitSummary * summary, char * map, int count )
 {
-    int i = 0;
+    //---VARIABLE(S)---
+    //  int(s)
+    int l;
+    int i;
+    int numChild = ( count + 63 ) / 64;
     
-    for( i = 0; i < MAX_INODE; i++ )
+    memset( summary, 0, sizeof( BitSummary ));
+    summary->map = map;
+    summary->count = count;
+    
+    for( l = 0; l < SUMMARY_LEVEL; l++ )
     {
-        if( get_bit( inodeMap, i ) == 0)
-        {            
-            set_bit( inodeMap, i, 1 );
+        summary->numWord[l] = ( numChild + 63 ) / 64;
+        summary->full[l] = malloc( summary->numWord[l] * sizeof( uint64_t ));
+        
+        if( summary->full[l] == NULL )
+        {
+            fprintf( stderr, "bitmap summary: out of memory\n" );
+            summary->levels = l;
+            summary_free( summary );
             
-            superBlock.freeInodeCount--;
+            return -1;
+        }
+        
+        memset( summary->full[l], 0xFF, summary->numWord[l] * sizeof( uint64_t ));
+        summary->levels = l + 1;
+        
+        for( i = 0; i < numChild; i++ )
+        {
+            int childFull = ( l == 0 ) ? summary_map_word( summary, i ) == UINT64_MAX
+                                       : summary->full[l - 1][i] == UINT64_MAX;
             
-            return i;
+            summary_mark( summary->full[l], i, childFull );
+        }
+        
+        if( summary->numWord[l] == 1 )
+        {
+            break;
         }
+        
+        numChild = summary->numWord[l];
     }
     
-    return -1;
+    return 0;
 }
 
 
 
 /**
- * Method: looks for a free block; returns block number
- *  if there is one
+ * Method: Frees the summary levels
  *
- * @param: None
+ * @param: BitSummary * summary - the summary to free
  *
- * Returns: int
+ * Returns: None
+ */
+void summary_free( BitSummary * summary )
+{
+    int l;
+    
+    for( l = 0; l < summary->levels; l++ )
+    {
+        free( summary->full[l] );
+        summary->full[l] = NULL;
+    }
+    
+    summary->levels = 0;
+}
+
+
+
+/**
+ * Method: Sets a bit of the map and updates the summary levels above
+ *  it, stopping at the first level whose bit does not change
+ *
+ * @param: BitSummary * summary - the map and its summary
+ * @param: int index - the bit to set
+ * @param: char value - 0 or 1
  *
+ * Returns: None
  */
-int get_free_block()
+void summary_set( BitSummary * summary, int index, char value )
 {
-    int i = 0;
+    //---VARIABLE(S)---
+    //  int(s)
+    int l;
+    int child = index / 64;
+    int full;
+    
+    set_bit( summary->map, index, value );
+    full = summary_map_word( summary, child ) == UINT64_MAX;
     
-    for( i = 0; i < MAX_BLOCK; i++ )
+    for( l = 0; l < summary->levels; l++ )
     {
-        if( get_bit( blockMap, i ) == 0 )
+        uint64_t before = summary->full[l][child / 64];
+        
+        full = summary_mark( summary->full[l], child, full );
+        
+        if( summary->full[l][child / 64] == before )
         {
-            set_bit( blockMap, i, 1 );
-            superBlock.freeBlockCount--;
-            
-            return i;
+            break;
+        }
+        
+        child /= 64;
+    }
+}
+
+
+
+/**
+ * Method: Finds the first child at or after index whose bit in a
+ *  summary level is clear, i.e. that still has a free bit under it;
+ *  whole words of full children are skipped by asking the level above
+ *
+ * @param: BitSummary * summary - the map and its summary
+ * @param: int l - the summary level
+ * @param: int index - the first child to look at
+ *
+ * Returns: int - the child index or -1 if everything after it is full
+ */
+int summary_next( BitSummary * summary, int l, int index )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int word = index / 64;
+    //  uint64_t(s)
+    uint64_t free;
+    
+    if( word >= summary->numWord[l] )
+    {
+        return -1;
+    }
+    
+    free = ~summary->full[l][word] & ( UINT64_MAX << ( index % 64 ));
+    
+    if( free == 0 )
+    {
+        if( l + 1 >= summary->levels )
+        {
+            return -1;
+        }
+        
+        word = summary_next( summary, l + 1, word + 1 );
+        
+        if( word < 0 )
+        {
+            return -1;
+        }
+        
+        free = ~summary->full[l][word];
+    }
+    
+    return word * 64 + __builtin_ctzll( free );
+}
+
+
+
+/**
+ * Method: Finds the first clear bit at or after start by walking down
+ *  the summary levels, so the cost grows with the number of levels
+ *  rather than the size of the map
+ *
+ * @param: BitSummary * summary - the map and its summary
+ * @param: int start - the first bit to look at
+ *
+ * Returns: int - the bit index or -1 if every bit from start on is set
+ */
+int summary_find_clear( BitSummary * summary, int start )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int word = start / 64;
+    //  uint64_t(s)
+    uint64_t free;
+    
+    if( start < 0 || start >= summary->count )
+    {
+        return -1;
+    }
+    
+    free = ~summary_map_word( summary, word ) & ( UINT64_MAX << ( start % 64 ));
+    
+    if( free == 0 )
+    {
+        word = summary_next( summary, 0, word + 1 );
+        
+        if( word < 0 )
+        {
+            return -1;
         }
+        
+        free = ~summary_map_word( summary, word );
+    }
+    
+    return word * 64 + __builtin_ctzll( free );
+}
+
+
+
+/**
+ * Method: Counts the clear bits of a map with popcount
+ *
+ * @param: BitSummary * summary - the map and its summary
+ *
+ * Returns: int
+ */
+int summary_count_free( BitSummary * summary )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int word;
+    int numFree = 0;
+    
+    for( word = 0; word < ( summary->count + 63 ) / 64; word++ )
+    {
+        numFree += 64 - __builtin_popcountll( summary_map_word( summary, word ));
+    }
+    
+    return numFree;
+}
+
+
+
+/**
+ * Method: Builds the summaries over the inode and block maps once they
+ *  are loaded or formatted, and corrects the superblock's free counts
+ *  if they disagree with the maps
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Returns: int
+ */
+int bitmap_summary_build( fs_t * fs )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int freeInode;
+    int freeBlock;
+    
+    if( summary_build( &fs->inodeSummary, fs->inodeMap, fs->superBlock.inodeCount ) < 0
+        || summary_build( &fs->blockSummary, fs->blockMap, fs->superBlock.blockCount ) < 0 )
+    {
+        return -1;
+    }
+    
+    freeInode = summary_count_free( &fs->inodeSummary );
+    freeBlock = summary_count_free( &fs->blockSummary );
+    
+    if( freeInode != fs->superBlock.freeInodeCount || freeBlock != fs->superBlock.freeBlockCount )
+    {
+        fprintf( stderr, "fs_mount: free counts %d blocks / %d inodes corrected to %d / %d\n",
+                 fs->superBlock.freeBlockCount, fs->superBlock.freeInodeCount, freeBlock, freeInode );
+        fs->superBlock.freeInodeCount = freeInode;
+        fs->superBlock.freeBlockCount = freeBlock;
+        mark_dirty( fs, 0 );
+    }
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Frees the inode and block map summaries at unmount
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Returns: None
+ */
+void bitmap_summary_free( fs_t * fs )
+{
+    summary_free( &fs->inodeSummary );
+    summary_free( &fs->blockSummary );
+}
+
+
+
+/**
+ * Method: Next-fit search of a bitmap; starts at the cursor and
+ *  wraps around to the beginning once
+ *
+ * @param: BitSummary * summary - the map and its summary
+ * @param: int cursor - where the last search left off
+ *
+ * Returns: int - the bit index or -1 if every bit is set
+ */
+int next_fit( BitSummary * summary, int cursor )
+{
+    int index;
+    
+    if( cursor < 0 || cursor >= summary->count )
+    {
+        cursor = 0;
+    }
+    
+    index = summary_find_clear( summary, cursor );
+    
+    if( index < 0 )
+    {
+        index = summary_find_clear( summary, 0 );
     }
     
-    return -1;
+    return index;
+}
+
+
+
+/*
+ * Method: Checks for a free inode and then returns it if
+ *  there is one; the search resumes after the last inode handed out
+ *
+ * PARAMETERS: fs_t * fs - the volume
+ *
+ * Returns: int
+ *
+ */
+int get_free_inode( fs_t * fs )
+{
+    int i;
+    
+    pthread_mutex_lock( &fs->allocLock );
+    i = next_fit( &fs->inodeSummary, fs->superBlock.nextFreeInode );
+    
+    if( i >= 0 )
+    {
+        summary_set( &fs->inodeSummary, i, 1 );
+        
+        __atomic_sub_fetch( &fs->superBlock.freeInodeCount, 1, __ATOMIC_RELAXED );
+        fs->superBlock.nextFreeInode = i + 1;
+        mark_dirty( fs, fs->superBlock.inodeMapStart + i / 8 / fs->superBlock.blockSize );
+        mark_dirty( fs, 0 );
+    }
+    
+    pthread_mutex_unlock( &fs->allocLock );
+    
+    return i;
+}
+
+
+
+/**
+ * Method: looks for a free block; returns block number
+ *  if there is one. The search resumes after the last block handed
+ *  out, so a nearly full volume is not rescanned from block 0
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Returns: int
+ *
+ */
+int get_free_block( fs_t * fs )
+{
+    int i;
+    
+    pthread_mutex_lock( &fs->allocLock );
+    i = next_fit( &fs->blockSummary, fs->superBlock.nextFreeBlock );
+    
+    if( i >= 0 )
+    {
+        summary_set( &fs->blockSummary, i, 1 );
+        __atomic_sub_fetch( &fs->superBlock.freeBlockCount, 1, __ATOMIC_RELAXED );
+        fs->superBlock.nextFreeBlock = i + 1;
+        mark_dirty( fs, fs->superBlock.blockMapStart + i / 8 / fs->superBlock.blockSize );
+        mark_dirty( fs, 0 );
+        extent_take( fs, i, 1 );
+    }
+    
+    pthread_mutex_unlock( &fs->allocLock );
+    
+    return i;
+}
+
+
+
+/**
+ * Method: Gives an inode back to the inode map
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the inode to free
+ *
+ * Returns: None
+ */
+void put_free_inode( fs_t * fs, int inodeNum )
+{
+    pthread_mutex_lock( &fs->allocLock );
+    summary_set( &fs->inodeSummary, inodeNum, 0 );
+    __atomic_add_fetch( &fs->superBlock.freeInodeCount, 1, __ATOMIC_RELAXED );
+    
+    mark_dirty( fs, fs->superBlock.inodeMapStart + inodeNum / 8 / fs->superBlock.blockSize );
+    mark_dirty( fs, 0 );
+    pthread_mutex_unlock( &fs->allocLock );
+}
+
+
+
+/**
+ * Method: Gives a data block back to the block map
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int block - the block to free
+ *
+ * Returns: None
+ */
+void put_free_block( fs_t * fs, int block )
+{
+    pthread_mutex_lock( &fs->allocLock );
+    
+    //  Freeing a block twice would corrupt the free-extent index
+    if( get_bit( fs->blockMap, block ) != 0 )
+    {
+        summary_set( &fs->blockSummary, block, 0 );
+        __atomic_add_fetch( &fs->superBlock.freeBlockCount, 1, __ATOMIC_RELAXED );
+        
+        mark_dirty( fs, fs->superBlock.blockMapStart + block / 8 / fs->superBlock.blockSize );
+        mark_dirty( fs, 0 );
+        extent_give( fs, block );
+    }
+    
+    pthread_mutex_unlock( &fs->allocLock );
+}
+
+
+
+/**
+ * Method: Binary search of the free-extent index, which is sorted by
+ *  start block
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int block - the block to look for
+ *
+ * Returns: int - the index of the last extent starting at or before
+ *      block, or -1 if every extent starts after it
+ */
+int extent_search( fs_t * fs, int block )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int low = 0;
+    int high = fs->numFreeExtents - 1;
+    int found = -1;
+    
+    while( low <= high )
+    {
+        int mid = ( low + high ) / 2;
+        
+        if( fs->freeExtents[mid].start <= block )
+        {
+            found = mid;
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+    
+    return found;
+}
+
+
+
+/**
+ * Method: Inserts an extent into the index, growing it when full
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int index - where the extent goes
+ * @param: int start - the first free block
+ * @param: int length - the number of free blocks
+ *
+ * Returns: int
+ */
+int extent_insert( fs_t * fs, int index, int start, int length )
+{
+    if( fs->numFreeExtents == fs->maxFreeExtents )
+    {
+        int newMax = fs->maxFreeExtents ? fs->maxFreeExtents * 2 : 64;
+        FreeExtent * grown = realloc( fs->freeExtents, newMax * sizeof( FreeExtent ));
+        
+        if( grown == NULL )
+        {
+            fprintf( stderr, "extent index: out of memory\n" );
+            
+            return -1;
+        }
+        
+        fs->freeExtents = grown;
+        fs->maxFreeExtents = newMax;
+    }
+    
+    memmove( &fs->freeExtents[index + 1], &fs->freeExtents[index], ( fs->numFreeExtents - index ) * sizeof( FreeExtent ));
+    fs->freeExtents[index].start = start;
+    fs->freeExtents[index].length = length;
+    fs->numFreeExtents++;
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Removes an extent from the index
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int index - the extent to remove
+ *
+ * Returns: None
+ */
+void extent_delete( fs_t * fs, int index )
+{
+    fs->numFreeExtents--;
+    memmove( &fs->freeExtents[index], &fs->freeExtents[index + 1], ( fs->numFreeExtents - index ) * sizeof( FreeExtent ));
+}
+
+
+
+/**
+ * Method: Removes a run of blocks that was just allocated from the
+ *  free-extent index; the run must lie inside one free extent, which
+ *  is shrunk or split around it
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int start - the first allocated block
+ * @param: int length - the number of allocated blocks
+ *
+ * Returns: None
+ */
+void extent_take( fs_t * fs, int start, int length )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i = extent_search( fs, start );
+    int end = start + length;
+    int extentEnd;
+    
+    if( i < 0 )
+    {
+        return;
+    }
+    
+    extentEnd = fs->freeExtents[i].start + fs->freeExtents[i].length;
+    
+    if( end > extentEnd )
+    {
+        return;
+    }
+    
+    if( start == fs->freeExtents[i].start && end == extentEnd )
+    {
+        extent_delete( fs, i );
+    }
+    else if( start == fs->freeExtents[i].start )
+    {
+        fs->freeExtents[i].start = end;
+        fs->freeExtents[i].length -= length;
+    }
+    else if( end == extentEnd )
+    {
+        fs->freeExtents[i].length -= length;
+    }
+    else
+    {
+        fs->freeExtents[i].length = start - fs->freeExtents[i].start;
+        extent_insert( fs, i + 1, end, extentEnd - end );
+    }
+}
+
+
+
+/**
+ * Method: Adds a freed block to the free-extent index, merging it
+ *  with the extents on either side
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int block - the block that was freed
+ *
+ * Returns: None
+ */
+void extent_give( fs_t * fs, int block )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i = extent_search( fs, block );
+    int joinPrev = ( i >= 0 && fs->freeExtents[i].start + fs->freeExtents[i].length == block );
+    int joinNext = ( i + 1 < fs->numFreeExtents && fs->freeExtents[i + 1].start == block + 1 );
+    
+    if( joinPrev && joinNext )
+    {
+        fs->freeExtents[i].length += 1 + fs->freeExtents[i + 1].length;
+        extent_delete( fs, i + 1 );
+    }
+    else if( joinPrev )
+    {
+        fs->freeExtents[i].length++;
+    }
+    else if( joinNext )
+    {
+        fs->freeExtents[i + 1].start--;
+        fs->freeExtents[i + 1].length++;
+    }
+    else
+    {
+        extent_insert( fs, i + 1, block, 1 );
+    }
+}
+
+
+
+/**
+ * Method: Rebuilds the free-extent index from the block map; called
+ *  once the map is loaded or formatted
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Returns: int
+ */
+int extent_index_build( fs_t * fs )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int start = 0;
+    int end;
+    
+    fs->numFreeExtents = 0;
+    
+    while(( start = find_clear_bit( fs->blockMap, start, fs->superBlock.blockCount )) >= 0 )
+    {
+        end = find_set_bit( fs->blockMap, start, fs->superBlock.blockCount );
+        
+        if( extent_insert( fs, fs->numFreeExtents, start, end - start ) < 0 )
+        {
+            return -1;
+        }
+        
+        start = end;
+    }
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Frees the free-extent index at unmount
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Returns: None
+ */
+void extent_index_free( fs_t * fs )
+{
+    free( fs->freeExtents );
+    fs->freeExtents = NULL;
+    fs->numFreeExtents = 0;
+    fs->maxFreeExtents = 0;
+}
+
+
+
+/**
+ * Method: Prints how fragmented the free space is
+ *
+ * @param: fs_t * fs - the volume
+ *
+ * Returns: None
+ */
+void extent_stat( fs_t * fs )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int largest = 0;
+    
+    pthread_mutex_lock( &fs->allocLock );
+    
+    for( i = 0; i < fs->numFreeExtents; i++ )
+    {
+        if( fs->freeExtents[i].length > largest )
+        {
+            largest = fs->freeExtents[i].length;
+        }
+    }
+    
+    printf( "# of free extents: %d, largest: %d blocks\n", fs->numFreeExtents, largest );
+    pthread_mutex_unlock( &fs->allocLock );
+}
+
+
+
+/**
+ * Method: Allocates up to want contiguous data blocks. The run starts
+ *  at goal when that block is free, so a growing file stays
+ *  contiguous; otherwise it is the first extent after the allocation
+ *  cursor that holds want blocks, or the largest extent if none does.
+ *  The caller holds allocLock
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int goal - the preferred first block, or -1 for none
+ * @param: int want - the number of blocks wanted
+ * @param: int * got - set to the number of blocks allocated
+ *
+ * Returns: int - the first block of the run or -1 if the disk is full
+ */
+int alloc_extent_locked( fs_t * fs, int goal, int want, int * got )
+{
+    //---VARIABLE(S)---
+    //  int(s)
+    int i;
+    int k;
+    int first;
+    int best = -1;
+    int start = -1;
+    int length = 0;
+    
+    *got = 0;
+    
+    if( want < 1 || fs->numFreeExtents == 0 )
+    {
+        return -1;
+    }
+    
+    if( goal >= 0 )
+    {
+        i = extent_search( fs, goal );
+        
+        if( i >= 0 && goal < fs->freeExtents[i].start + fs->freeExtents[i].length )
+        {
+            start = goal;
+            length = fs->freeExtents[i].start + fs->freeExtents[i].length - goal;
+        }
+    }
+    
+    if( start < 0 )
+    {
+        //  Next fit over the extents, wrapping around once
+        first = extent_search( fs, fs->superBlock.nextFreeBlock - 1 ) + 1;
+        
+        for( k = 0; k < fs->numFreeExtents; k++ )
+        {
+            i = ( first + k ) % fs->numFreeExtents;
+            
+            if( fs->freeExtents[i].length >= want )
+            {
+                best = i;
+                
+                break;
+            }
+            
+            if( best < 0 || fs->freeExtents[i].length > fs->freeExtents[best].length )
+            {
+                best = i;
+            }
+        }
+        
+        start = fs->freeExtents[best].start;
+        length = fs->freeExtents[best].length;
+    }
+    
+    if( length > want )
+    {
+        length = want;
+    }
+    
+    for( i = start; i < start + length; i++ )
+    {
+        summary_set( &fs->blockSummary, i, 1 );
+    }
+    
+    for( i = start / 8 / fs->superBlock.blockSize; i <= ( start + length - 1 ) / 8 / fs->superBlock.blockSize; i++ )
+    {
+        mark_dirty( fs, fs->superBlock.blockMapStart + i );
+    }
+    
+    __atomic_sub_fetch( &fs->superBlock.freeBlockCount, length, __ATOMIC_RELAXED );
+    fs->superBlock.nextFreeBlock = start + length;
+    mark_dirty( fs, 0 );
+    extent_take( fs, start, length );
+    
+    *got = length;
+    
+    return start;
+}
+
+
+
+/**
+ * Method: alloc_extent_locked under the allocator lock
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int goal - the preferred first block, or -1 for none
+ * @param: int want - the number of blocks wanted
+ * @param: int * got - set to the number of blocks allocated
+ *
+ * Returns: int - the first block of the run or -1 if the disk is full
+ */
+int alloc_extent( fs_t * fs, int goal, int want, int * got )
+{
+    int start;
+    
+    pthread_mutex_lock( &fs->allocLock );
+    start = alloc_extent_locked( fs, goal, want, got );
+    pthread_mutex_unlock( &fs->allocLock );
+    
+    return start;
+}
+
+
+
+/**
+ * Method: Sets aside count free blocks for an allocation that is about
+ *  to run. Space is checked and claimed under allocLock, so two
+ *  commands cannot both count the same free blocks
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int count - the number of blocks the caller may allocate
+ *
+ * Returns: int - 0, or -1 if that many blocks are not free
+ */
+int reserve_blocks( fs_t * fs, int count )
+{
+    int result = -1;
+    
+    pthread_mutex_lock( &fs->allocLock );
+    
+    if( fs->superBlock.freeBlockCount - fs->reservedBlocks >= count )
+    {
+        fs->reservedBlocks += count;
+        result = 0;
+    }
+    
+    pthread_mutex_unlock( &fs->allocLock );
+    
+    return result;
+}
+
+
+
+/**
+ * Method: Gives back a reservation once its allocation is done, the
+ *  blocks it took being off the free count by then
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int count - the number of blocks reserved
+ *
+ * Returns: None
+ */
+void unreserve_blocks( fs_t * fs, int count )
+{
+    pthread_mutex_lock( &fs->allocLock );
+    fs->reservedBlocks -= count;
+    pthread_mutex_unlock( &fs->allocLock );
+}
+
+
+
+/**
+ * Method: Records that the in-memory copy of a metadata block (the
+ *  superblock, a bitmap block or an inode table block) has changed,
+ *  so the next sync writes it
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int block - the metadata block number
+ *
+ * Returns: None
+ */
+void mark_dirty( fs_t * fs, int block )
+{
+    //  Inodes that share a table block are changed from several threads
+    __atomic_fetch_or( &fs->metaDirty[block / 8], ( char )( 1 << ( block % 8 )), __ATOMIC_RELAXED );
+}
+
+
+
+/**
+ * Method: Marks the inode table block holding an inode as changed
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int inodeNum - the inode that was changed
+ *
+ * Returns: None
+ */
+void dirty_inode( fs_t * fs, int inodeNum )
+{
+    mark_dirty( fs, fs->superBlock.inodeTableStart + ( int )(( long long ) inodeNum * sizeof( Inode ) / fs->superBlock.blockSize ));
+}
+
+
+
+/**
+ * Method: Reads a structure that is smaller than a block, such as the
+ *  SuperBlock or a Dentry, from the start of a block
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int block - the block to read
+ * @param: void * buf - the structure to fill
+ * @param: size_t size - the size of the structure
+ *
+ * Returns: int
+ */
+int read_struct( fs_t * fs, int block, void * buf, size_t size )
+{
+    if( cache_read( &fs->cache, block, fs->structBuf ) < 0 )
+    {
+        return -1;
+    }
+    
+    memcpy( buf, fs->structBuf, size );
+    
+    return 0;
+}
+
+
+
+/**
+ * Method: Writes a structure that is smaller than a block to the start
+ *  of a block; the rest of the block is zeroed
+ *
+ * @param: fs_t * fs - the volume
+ * @param: int block - the block to write
+ * @param: void * buf - the structure to write
+ * @param: size_t size - the size of the structure
+ *
+ * Returns: int
+ */
+int write_struct( fs_t * fs, int block, void * buf, size_t size )
+{
+    memcpy( fs->structBuf, buf, size );
+    memset( fs->structBuf + size, 0, fs->disk.blockSize - size );
+    
+    return cache_write( &fs->cache, block, fs->structBuf );
 }
 
 
@@ -177,8 +1271,9 @@ int get_free_block()
 int format_timeval( struct timeval * tv, char * buf, size_t sz )
 {
     ssize_t written = -1;
-    struct tm * gm;
-    gm = gmtime( &tv -> tv_sec );
+    struct tm tm;
+    //  gmtime_r, as stat runs in several threads at once
+    struct tm * gm = gmtime_r( &tv -> tv_sec, &tm );
     
     if( gm )
     {
@@ -9,9 +9,26 @@
  *********************************************************/
 
 //---METHOD INSTANTIATION(S)---
-int get_free_inode();
-int get_free_block();
+int get_free_inode( fs_t * fs );
+int get_free_block( fs_t * fs );
+int alloc_extent( fs_t * fs, int goal, int want, int * got );
+int reserve_blocks( fs_t * fs, int count );
+void unreserve_blocks( fs_t * fs, int count );
+int extent_index_build( fs_t * fs );
+void extent_take( fs_t * fs, int start, int length );
+void extent_give( fs_t * fs, int block );
+void extent_index_free( fs_t * fs );
+void extent_stat( fs_t * fs );
+int bitmap_summary_build( fs_t * fs );
+void bitmap_summary_free( fs_t * fs );
+void summary_free( BitSummary * summary );
+void put_free_inode( fs_t * fs, int inodeNum );
+void put_free_block( fs_t * fs, int block );
+void mark_dirty( fs_t * fs, int block );
+void dirty_inode( fs_t * fs, int inodeNum );
 int rand_string( char * str, size_t size );
 int format_timeval( struct timeval * tv, char * buf, size_t sz );
+int read_struct( fs_t * fs, int block, void * buf, size_t size );
+int write_struct( fs_t * fs, int block, void * buf, size_t size );
 char get_bit( char * array, int index );
 void set_bit( char * array, int index, char value );
\ No newline at end of file